@@ -0,0 +1,205 @@
+/**
+ ******************************************************************************
+ * @file    allocstats.hpp
+ * @author  Maxim <aveter@bk.ru>
+ * @date    08/06/2019
+ * @brief   Description of the statistics of the memory pools.
+ *
+ * The statistics are collected only if ALLOCATOR_STATS is defined, otherwise
+ * all the counters are compiled out.
+ ******************************************************************************
+ */
+
+#ifndef ALLOCSTATS_HPP_
+#define ALLOCSTATS_HPP_
+
+#include <cstddef>
+#include <ostream>
+
+#ifdef ALLOCATOR_STATS
+#include <chrono>
+#endif
+
+
+/** Number of the buckets of the latency histogram. */
+const std::size_t STATS_LATENCY_BUCKETS = 16;
+
+/** Every STATS_SAMPLE_RATE-th allocation is timed, the power of 2. */
+const std::size_t STATS_SAMPLE_RATE = 64;
+
+
+/**
+ * The snapshot of the pool statistics.
+ */
+struct pool_stats_snapshot
+{
+  bool enabled = false;         /**< - the statistics are collected. */
+  std::size_t allocs = 0;       /**< - number of the allocations. */
+  std::size_t frees = 0;        /**< - number of the deallocations. */
+  std::size_t in_use = 0;       /**< - number of the occupied cells. */
+  std::size_t high_water = 0;   /**< - maximum of the occupied cells. */
+  std::size_t capacity = 0;     /**< - number of all the cells. */
+  std::size_t fills = 0;        /**< - allocations found the pool filled. */
+  std::size_t grows = 0;        /**< - blocks added by the growth policy. */
+  std::size_t fallbacks = 0;    /**< - requests served by the system heap. */
+  std::size_t pooled_runs = 0;  /**< - requests served by the size classes. */
+
+  /** Sampled allocation latency, bucket i counts [2^(i-1), 2^i) ns. */
+  std::size_t latency[STATS_LATENCY_BUCKETS] = {};
+};
+
+
+/**
+ * @brief Print the statistics.
+ * @param os [in] - output stream.
+ * @param stats [in] - the snapshot of the statistics.
+ * @return the output stream.
+ */
+inline std::ostream & operator<<(std::ostream &os,
+                                 const pool_stats_snapshot &stats)
+{
+  os << "capacity=" << stats.capacity << " in_use=" << stats.in_use;
+  if (!stats.enabled)
+    return os << " (statistics disabled)";
+
+  os << " high_water=" << stats.high_water << " allocs=" << stats.allocs
+     << " frees=" << stats.frees << " fills=" << stats.fills
+     << " grows=" << stats.grows << " fallbacks=" << stats.fallbacks
+     << " pooled_runs=" << stats.pooled_runs << " latency_ns={";
+
+  for (std::size_t i = 0; i < STATS_LATENCY_BUCKETS; ++i) {
+    if (stats.latency[i] == 0)
+      continue;
+    os << " <" << (std::size_t(1) << i) << ":" << stats.latency[i];
+  }
+  return os << " }";
+}
+
+
+#ifdef ALLOCATOR_STATS
+
+/**
+ * Discription of the counters of the pool.
+ */
+class pool_stats
+{
+  public:
+    /**
+     * @brief The cells are allocated.
+     * @param in_use [in] - number of the occupied cells.
+     * @param count [in] - number of the allocated cells.
+     */
+    void on_alloc(std::size_t in_use, std::size_t count = 1) {
+      allocs_ += count;
+      if (in_use > high_water_)
+        high_water_ = in_use;
+    }
+
+    /**
+     * @brief The cells are deallocated.
+     * @param count [in] - number of the deallocated cells.
+     */
+    void on_free(std::size_t count = 1) {
+      frees_ += count;
+    }
+
+    /**
+     * @brief The allocation found no free cells.
+     */
+    void on_fill() {
+      ++fills_;
+    }
+
+    /**
+     * @brief The block is added.
+     */
+    void on_grow() {
+      ++grows_;
+    }
+
+    /**
+     * @brief Call the allocation, every STATS_SAMPLE_RATE-th call is timed.
+     * @tparam F - type of the allocation.
+     * @param f [in] - the allocation.
+     * @return the result of the allocation.
+     */
+    template<typename F>
+    auto timed(F f) -> decltype(f()) {
+      if ((++tick_ & (STATS_SAMPLE_RATE - 1)) != 0)
+        return f();
+
+      auto start = std::chrono::steady_clock::now();
+      auto res = f();
+      auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                  std::chrono::steady_clock::now() - start).count();
+
+      std::size_t bucket = 0;
+      while (bucket + 1 < STATS_LATENCY_BUCKETS && (ns >> bucket) != 0)
+        ++bucket;
+      ++latency_[bucket];
+      return res;
+    }
+
+    /**
+     * @brief The snapshot of the counters.
+     * @param in_use [in] - number of the occupied cells.
+     * @param capacity [in] - number of all the cells.
+     * @return the snapshot.
+     */
+    pool_stats_snapshot snapshot(std::size_t in_use,
+                                 std::size_t capacity) const {
+      pool_stats_snapshot res;
+      res.enabled = true;
+      res.allocs = allocs_;
+      res.frees = frees_;
+      res.in_use = in_use;
+      res.high_water = high_water_;
+      res.capacity = capacity;
+      res.fills = fills_;
+      res.grows = grows_;
+      for (std::size_t i = 0; i < STATS_LATENCY_BUCKETS; ++i)
+        res.latency[i] = latency_[i];
+      return res;
+    }
+
+
+  private:
+    std::size_t allocs_ = 0;      /**< - number of the allocations. */
+    std::size_t frees_ = 0;       /**< - number of the deallocations. */
+    std::size_t high_water_ = 0;  /**< - maximum of the occupied cells. */
+    std::size_t fills_ = 0;       /**< - allocations found the pool filled. */
+    std::size_t grows_ = 0;       /**< - blocks added. */
+    std::size_t tick_ = 0;        /**< - counter of the sampling. */
+    std::size_t latency_[STATS_LATENCY_BUCKETS] = {}; /**< - histogram */
+};
+
+#else
+
+/**
+ * Discription of the counters of the pool, the statistics are disabled.
+ */
+class pool_stats
+{
+  public:
+    void on_alloc(std::size_t, std::size_t = 1) {}
+    void on_free(std::size_t = 1) {}
+    void on_fill() {}
+    void on_grow() {}
+
+    template<typename F>
+    auto timed(F f) -> decltype(f()) {
+      return f();
+    }
+
+    pool_stats_snapshot snapshot(std::size_t in_use,
+                                 std::size_t capacity) const {
+      pool_stats_snapshot res;
+      res.in_use = in_use;
+      res.capacity = capacity;
+      return res;
+    }
+};
+
+#endif /* ALLOCATOR_STATS */
+
+#endif /* ALLOCSTATS_HPP_ */
@@ -0,0 +1,291 @@
+/**
+ ******************************************************************************
+ * @file    alloctrace.hpp
+ * @author  Maxim <aveter@bk.ru>
+ * @date    29/06/2019
+ * @brief   Description of the trace of the allocations.
+ *
+ * The events are recorded only if ALLOCATOR_TRACE is defined, otherwise the
+ * recording is compiled out. The format of the file is always defined, it is
+ * read by the replay tool.
+ ******************************************************************************
+ */
+
+#ifndef ALLOCTRACE_HPP_
+#define ALLOCTRACE_HPP_
+
+#include <cstddef>
+#include <cstdint>
+
+#ifdef ALLOCATOR_TRACE
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <mutex>
+#include <utility>
+
+#include <dirent.h>
+#include <sys/stat.h>
+#endif
+
+
+/** Version of the format of the trace file. */
+const std::uint32_t TRACE_VERSION = 1;
+
+
+/**
+ * The operations of the trace.
+ */
+enum trace_op : std::uint8_t
+{
+  trace_alloc = 0,       /**< - the memory is allocated. */
+  trace_free = 1         /**< - the memory is released. */
+};
+
+
+/**
+ * The memory which serves the request.
+ */
+enum trace_pool : std::uint8_t
+{
+  trace_single = 0,      /**< - the buffer of single objects. */
+  trace_runs = 1,        /**< - the size classes of several objects. */
+  trace_heap = 2         /**< - the system heap. */
+};
+
+
+/**
+ * The header of the trace file.
+ */
+struct trace_header
+{
+  char magic[8] = {'A', 'L', 'L', 'O', 'C', 'T', 'R', 'C'}; /**< - signature */
+  std::uint32_t version = TRACE_VERSION;    /**< - version of the format. */
+  std::uint32_t event_size = 0;             /**< - sizeof(trace_event). */
+};
+
+
+/**
+ * The event of the trace, the events follow the header in the file.
+ */
+struct trace_event
+{
+  std::uint64_t time;       /**< - nanoseconds since the start of recording. */
+  std::uint64_t addr;       /**< - address of the memory. */
+  std::uint32_t allocator;  /**< - number of the allocator in the process. */
+  std::uint32_t count;      /**< - number of the objects. */
+  std::uint32_t size;       /**< - size of the object. */
+  std::uint8_t op;          /**< - trace_op. */
+  std::uint8_t pool;        /**< - trace_pool. */
+  std::uint16_t reserved;   /**< - zero. */
+};
+
+static_assert(sizeof(trace_event) == 32, "The event must be packed");
+
+
+#ifdef ALLOCATOR_TRACE
+
+/**
+ * Discription of the writer of the trace file, one for the process.
+ *
+ * The file is named by the ALLOCATOR_TRACE_FILE environment variable, by
+ * default "allocator.trace". The file which is already open in the process
+ * (the trace read by the replay tool) is not overwritten: nothing is
+ * recorded. The writer is never destroyed, so the allocators of the static
+ * objects can record to the end; the buffer of the file is flushed on the
+ * exit.
+ */
+class trace_writer
+{
+  public:
+    /**
+     * @brief The writer of the process, is opened on the first call.
+     * @return reference to the writer.
+     */
+    static trace_writer & instance() {
+      static trace_writer *writer = new trace_writer();
+      return *writer;
+    }
+
+    /**
+     * @brief Number of the new allocator.
+     * @return the number.
+     */
+    std::uint32_t next_id() {
+      std::lock_guard<std::mutex> lock(mutex_);
+      return next_id_++;
+    }
+
+    /**
+     * @brief Record the event.
+     * @param id [in] - number of the allocator.
+     * @param op [in] - the operation.
+     * @param ptr [in] - address of the memory.
+     * @param count [in] - number of the objects.
+     * @param size [in] - size of the object.
+     * @param pool [in] - the memory which serves the request.
+     */
+    void write(std::uint32_t id, trace_op op, const void *ptr,
+               std::size_t count, std::size_t size, trace_pool pool) {
+      trace_event event;
+      event.time = static_cast<std::uint64_t>(
+                     std::chrono::duration_cast<std::chrono::nanoseconds>(
+                       std::chrono::steady_clock::now() - start_).count());
+      event.addr = reinterpret_cast<std::uintptr_t>(ptr);
+      event.allocator = id;
+      event.count = static_cast<std::uint32_t>(count);
+      event.size = static_cast<std::uint32_t>(size);
+      event.op = op;
+      event.pool = pool;
+      event.reserved = 0;
+
+      std::lock_guard<std::mutex> lock(mutex_);
+      if (file_ != nullptr)
+        std::fwrite(&event, sizeof(event), 1, file_);
+    }
+
+
+  private:
+    /** Size of the buffer of the file. */
+    static constexpr std::size_t BUFFER_SIZE = 1 << 20;
+
+    std::FILE *file_ = nullptr;     /**< - the trace file, nullptr on error */
+    std::mutex mutex_;              /**< - the allocators of all threads */
+    std::uint32_t next_id_ = 0;     /**< - number of the next allocator */
+    std::chrono::steady_clock::time_point start_; /**< - start of recording */
+
+    /**
+     * @brief Open the file and write the header.
+     */
+    trace_writer()
+      : start_(std::chrono::steady_clock::now()) {
+      const char *path = std::getenv("ALLOCATOR_TRACE_FILE");
+      if (path == nullptr)
+        path = "allocator.trace";
+      if (is_open(path))
+        return;
+
+      file_ = std::fopen(path, "wb");
+      if (file_ == nullptr)
+        return;
+
+      std::setvbuf(file_, nullptr, _IOFBF, BUFFER_SIZE);
+      trace_header header;
+      header.event_size = sizeof(trace_event);
+      std::fwrite(&header, sizeof(header), 1, file_);
+    }
+
+    /**
+     * @brief Check that the file is open in the process, by the descriptors
+     *        of /proc/self/fd.
+     * @param path [in] - path to the file.
+     * @return true if the file is open, false if it is not or the descriptors
+     *         can not be listed.
+     */
+    static bool is_open(const char *path) {
+      struct stat file;
+      if (::stat(path, &file) != 0)
+        return false;
+
+      DIR *dir = ::opendir("/proc/self/fd");
+      if (dir == nullptr)
+        return false;
+
+      bool found = false;
+      const int own = ::dirfd(dir);
+      while (const dirent *entry = ::readdir(dir)) {
+        char *end = nullptr;
+        const long fd = std::strtol(entry->d_name, &end, 10);
+        if (end == entry->d_name || *end != '\0' || fd == own)
+          continue;
+
+        struct stat desc;
+        if (::fstat(static_cast<int>(fd), &desc) == 0 &&
+            desc.st_dev == file.st_dev && desc.st_ino == file.st_ino) {
+          found = true;
+          break;
+        }
+      }
+      ::closedir(dir);
+      return found;
+    }
+};
+
+
+/**
+ * Discription of the trace of the allocator.
+ *
+ * Every allocator has its own number; the copy of the allocator starts with
+ * its own memory, so it gets the new number. The moved one keeps it and the
+ * source, left with no memory, gets the new number; the move operator swaps
+ * the numbers with the memory.
+ */
+class alloc_trace
+{
+  public:
+    alloc_trace()
+      : id_(trace_writer::instance().next_id())
+    {}
+
+    alloc_trace(const alloc_trace &)
+      : alloc_trace()
+    {}
+
+    alloc_trace & operator=(const alloc_trace &) {
+      return *this;
+    }
+
+    alloc_trace(alloc_trace &&other)
+      : id_(other.id_) {
+      other.id_ = trace_writer::instance().next_id();
+    }
+
+    alloc_trace & operator=(alloc_trace &&other) {
+      std::swap(id_, other.id_);
+      return *this;
+    }
+
+    /**
+     * @brief The memory is allocated.
+     * @param ptr [in] - address of the memory.
+     * @param count [in] - number of the objects.
+     * @param size [in] - size of the object.
+     * @param pool [in] - the memory which serves the request.
+     */
+    void on_alloc(const void *ptr, std::size_t count, std::size_t size,
+                  trace_pool pool) {
+      trace_writer::instance().write(id_, trace_alloc, ptr, count, size, pool);
+    }
+
+    /**
+     * @brief The memory is released.
+     * @param ptr [in] - address of the memory.
+     * @param count [in] - number of the objects.
+     * @param size [in] - size of the object.
+     * @param pool [in] - the memory which serves the request.
+     */
+    void on_free(const void *ptr, std::size_t count, std::size_t size,
+                 trace_pool pool) {
+      trace_writer::instance().write(id_, trace_free, ptr, count, size, pool);
+    }
+
+
+  private:
+    std::uint32_t id_;    /**< - number of the allocator. */
+};
+
+#else
+
+/**
+ * Discription of the trace of the allocator, the recording is disabled.
+ */
+class alloc_trace
+{
+  public:
+    void on_alloc(const void *, std::size_t, std::size_t, trace_pool) {}
+    void on_free(const void *, std::size_t, std::size_t, trace_pool) {}
+};
+
+#endif
+
+#endif /* ALLOCTRACE_HPP_ */
@@ -0,0 +1,255 @@
+/**
+ ******************************************************************************
+ * @file    arenaallocator.hpp
+ * @author  Maxim <aveter@bk.ru>
+ * @date    21/05/2019
+ * @brief   Description of the templates "Fixed Arena" and "Arena Allocator".
+ ******************************************************************************
+ */
+
+#ifndef ARENAALLOCATOR_HPP_
+#define ARENAALLOCATOR_HPP_
+
+#include "sizeclasspool.hpp"
+
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+
+/**
+ * Discription of the "Fixed Arena" class.
+ *
+ * The arena does not depend on the type of the data: the memory is served by
+ * the size classes of 1, 2, 4 ... 16 units of std::max_align_t, so one arena
+ * is shared by the allocators of the different types. Only the larger
+ * requests (or when the size class is filled) go to the system heap.
+ * @tparam ELEMENTS - number of units reserved for each size class.
+ * @tparam GROWTH - growth policy of the size classes. Default on no_growth.
+ */
+template<std::size_t ELEMENTS, typename GROWTH = no_growth>
+class fixed_arena
+{
+  public:
+    /** The largest number of units served by the size classes. */
+    static constexpr std::size_t MAX_POOLED_UNITS = 16;
+
+    /** The largest number of bytes served by the size classes. */
+    static constexpr std::size_t MAX_POOLED_BYTES =
+        MAX_POOLED_UNITS * sizeof(std::max_align_t);
+
+    /**
+     * @brief Allocate memory.
+     * @param bytes [in] - number of bytes.
+     * @return pointer to the allocated memory.
+     */
+    void * alloc(std::size_t bytes) {
+      std::size_t units = to_units(bytes);
+      if (units <= MAX_POOLED_UNITS) {
+        void *res = units_.alloc(units);
+        if (res != nullptr) {
+          ++pooled_count_;
+          return res;
+        }
+      }
+
+      ++fallback_count_;
+      return ::operator new(bytes);
+    }
+
+    /**
+     * @brief Deallocate memory.
+     * @param ptr [in] - pointer to the memory.
+     * @param bytes [in] - number of bytes.
+     */
+    void dealloc(void *ptr, std::size_t bytes) {
+      std::size_t units = to_units(bytes);
+      if (units <= MAX_POOLED_UNITS &&
+          units_.dealloc(static_cast<std::max_align_t *>(ptr), units))
+        return;
+
+      ::operator delete(ptr);
+    }
+
+    /**
+     * @brief Number of the requests that went to the system heap.
+     * @return number of the requests.
+     */
+    std::size_t fallback_count() const {
+      return fallback_count_;
+    }
+
+    /**
+     * @brief Number of the requests served by the size classes.
+     * @return number of the requests.
+     */
+    std::size_t pooled_count() const {
+      return pooled_count_;
+    }
+
+
+  private:
+    size_class_pool<std::max_align_t, ELEMENTS, GROWTH, 1, MAX_POOLED_UNITS>
+        units_;                           /**< - size classes */
+    std::size_t fallback_count_ = 0;      /**< - requests to the heap */
+    std::size_t pooled_count_ = 0;        /**< - requests to the classes */
+
+    /**
+     * @brief Number of units for the request.
+     * @param bytes [in] - number of bytes.
+     * @return number of units, at least one.
+     */
+    static std::size_t to_units(std::size_t bytes) {
+      std::size_t units = (bytes + sizeof(std::max_align_t) - 1) /
+                          sizeof(std::max_align_t);
+      return units > 0 ? units : 1;
+    }
+};
+
+
+/**
+ * Discription of the "Arena Allocator" class.
+ *
+ * The allocator keeps the reference-counted handle of the arena: all the
+ * copies and the rebinds share it, so the memory allocated by one of them may
+ * be freed by any other. The arena is propagated with the container on the
+ * copy, move and swap, so the container moves and swaps are O(1). Several
+ * containers can share one arena if their allocators are constructed from
+ * the same handle.
+ * @tparam T - data types.
+ * @tparam ARENA - type of the arena. Default on fixed_arena<1024>.
+ */
+template<typename T, typename ARENA = fixed_arena<1024>>
+class arena_allocator
+{
+  static_assert(alignof(T) <= alignof(std::max_align_t),
+                "The over-aligned types are not supported by the arena");
+
+  public:
+    /* Aliases */
+    using value_type = T;
+    using pointer = T *;
+    using const_pointer = const T *;
+    using reference = T &;
+    using const_reference = const T &;
+    using arena_t = ARENA;
+
+    using propagate_on_container_copy_assignment = std::true_type;
+    using propagate_on_container_move_assignment = std::true_type;
+    using propagate_on_container_swap = std::true_type;
+    using is_always_equal = std::false_type;
+
+
+    template<typename U>
+    struct rebind {
+      using other = arena_allocator<U, ARENA>;
+    };
+
+    /**
+     * The default constructor, creates the new arena.
+     */
+    arena_allocator()
+      : arena_(std::make_shared<ARENA>())
+    {}
+
+    /**
+     * @brief Constructor with the shared arena.
+     * @param arena [in] - handle of the arena.
+     */
+    explicit arena_allocator(std::shared_ptr<ARENA> arena)
+      : arena_(std::move(arena))
+    {}
+
+    /**
+     * @brief Converting constructor, the rebind shares the arena.
+     * @param other [in] - the allocator of the other type.
+     */
+    template<typename U>
+    arena_allocator(const arena_allocator<U, ARENA> &other)
+      : arena_(other.arena())
+    {}
+
+    /* The moved allocator has to keep its arena, so it is copied */
+    arena_allocator(const arena_allocator &) = default;
+    arena_allocator &operator=(const arena_allocator &) = default;
+    ~arena_allocator() = default;
+
+    /**
+     * @brief allocation of a given "piece" of memory.
+     * @param n [in] - amount of memory requested.
+     * @return pointer to the allocated memory.
+     */
+    pointer allocate(std::size_t n) {
+      return static_cast<pointer>(arena_->alloc(n * sizeof(T)));
+    }
+
+    /**
+     * @brief Release a specified amount of memory.
+     * @param p [in] - pointer to the beginning of the memory.
+     * @param n [in] - size of free memory.
+     */
+    void deallocate(pointer p, std::size_t n) {
+      arena_->dealloc(p, n * sizeof(T));
+    }
+
+    /**
+     * @brief Object construction.
+     * @tparam U - type of object constructed.
+     * @tparam Args - constructor parameters.
+     * @param p [in] - pointer of the object.
+     * @param args [in] - input parameters of the constructor.
+     */
+    template<class U, class... Args>
+    void construct(U *p, Args &&... args) {
+      ::new((void *) p) U(std::forward<Args>(args)...);
+    }
+
+    /**
+     * @brief Object distruction.
+     * @tparam U - type of object distroy.
+     * @param p [in] - pointer of the object.
+     */
+    template<class U>
+    void destroy(U *p) {
+      p->~U();
+    }
+
+    /**
+     * @brief Handle of the arena.
+     * @return shared pointer to the arena.
+     */
+    const std::shared_ptr<ARENA> & arena() const {
+      return arena_;
+    }
+
+
+  private:
+    std::shared_ptr<ARENA> arena_;  /**< - the shared arena. */
+};
+
+
+/**
+ * @brief Comparison operator.
+ * @return true if the allocators share the arena.
+ */
+template<typename T, typename U, typename ARENA>
+bool operator==(const arena_allocator<T, ARENA> &lhs,
+                const arena_allocator<U, ARENA> &rhs)
+{
+  return lhs.arena() == rhs.arena();
+}
+
+/**
+ * @brief Inequality operator.
+ * @return true if the allocators have the different arenas.
+ */
+template<typename T, typename U, typename ARENA>
+bool operator!=(const arena_allocator<T, ARENA> &lhs,
+                const arena_allocator<U, ARENA> &rhs)
+{
+  return !(lhs == rhs);
+}
+
+#endif  /* ARENAALLOCATOR_HPP_ */
@@ -0,0 +1,281 @@
+/**
+ ******************************************************************************
+ * @file    backingpolicy.hpp
+ * @author  Maxim <aveter@bk.ru>
+ * @date    10/06/2019
+ * @brief   Description of the backing storage policies for the "Chunk List".
+ ******************************************************************************
+ */
+
+#ifndef BACKINGPOLICY_HPP_
+#define BACKINGPOLICY_HPP_
+
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <type_traits>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <sys/mman.h>
+#include <unistd.h>
+#define BACKING_HAS_MMAP
+#endif
+
+
+/**
+ * The blocks are allocated in the system heap.
+ *
+ * The heap guarantees only the alignment of std::max_align_t, so the block
+ * for the over-aligned type is allocated larger and aligned inside, the
+ * address of the allocation is kept right before the block.
+ */
+struct heap_backing
+{
+  /**
+   * @brief Allocate the block.
+   * @param bytes [in] - size of the block.
+   * @param align [in] - alignment of the block, the power of 2.
+   * @return pointer to the block, std::bad_alloc is thrown on failure.
+   */
+  static void * alloc(std::size_t bytes, std::size_t align) {
+    if (align <= alignof(std::max_align_t))
+      return ::operator new[](bytes);
+
+    unsigned char *raw = static_cast<unsigned char *>(
+                           ::operator new[](bytes + align + sizeof(void *)));
+    std::uintptr_t addr =
+        reinterpret_cast<std::uintptr_t>(raw + sizeof(void *));
+    addr = (addr + align - 1) & ~static_cast<std::uintptr_t>(align - 1);
+
+    void *res = reinterpret_cast<void *>(addr);
+    static_cast<void **>(res)[-1] = raw;
+    return res;
+  }
+
+  /**
+   * @brief Release the block.
+   * @param ptr [in] - pointer to the block.
+   * @param align [in] - alignment of the block, the same as on the
+   *                     allocation.
+   */
+  static void release(void *ptr, std::size_t, std::size_t align) {
+    if (ptr != nullptr && align > alignof(std::max_align_t))
+      ptr = static_cast<void **>(ptr)[-1];
+    ::operator delete[](ptr);
+  }
+};
+
+
+/**
+ * Options of the mapped blocks, can be combined.
+ */
+enum backing_options : unsigned
+{
+  backing_thp = 1,       /**< - advise the transparent huge pages. */
+  backing_hugetlb = 2,   /**< - map the explicit huge pages (2 MB). */
+  backing_prefault = 4,  /**< - touch all the pages on the allocation. */
+  backing_lock = 8       /**< - lock the pages in the memory. */
+};
+
+
+/**
+ * The blocks are mapped with mmap.
+ *
+ * Large pools avoid the TLB misses with the huge pages and the page faults of
+ * the first touch with prefaulting, both out of the allocation path. If the
+ * explicit huge pages are not reserved the normal pages are mapped, the
+ * failure of the advice or the lock is ignored. Without mmap the blocks go to
+ * the system heap.
+ *
+ * The mapping is aligned on the page, the larger alignment is not supported.
+ * @tparam OPTIONS - combination of backing_options. Default on backing_thp.
+ */
+template<unsigned OPTIONS = backing_thp>
+struct mmap_backing
+{
+  /** Size of the explicit huge page. */
+  static constexpr std::size_t HUGE_PAGE = 2 * 1024 * 1024;
+
+#ifdef BACKING_HAS_MMAP
+  /**
+   * @brief Allocate the block.
+   * @param bytes [in] - size of the block.
+   * @param align [in] - alignment of the block, not larger than the page.
+   * @return pointer to the block, std::bad_alloc is thrown on failure.
+   */
+  static void * alloc(std::size_t bytes, std::size_t align) {
+    if (bytes == 0)
+      return nullptr;
+    if (align > static_cast<std::size_t>(::sysconf(_SC_PAGESIZE)))
+      throw std::bad_alloc();
+
+    std::size_t size = map_size(bytes);
+    void *ptr = MAP_FAILED;
+
+#ifdef MAP_HUGETLB
+    if (OPTIONS & backing_hugetlb)
+      ptr = ::mmap(nullptr, size, PROT_READ | PROT_WRITE,
+                   MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+#endif
+    if (ptr == MAP_FAILED)
+      ptr = ::mmap(nullptr, size, PROT_READ | PROT_WRITE,
+                   MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (ptr == MAP_FAILED)
+      throw std::bad_alloc();
+
+#ifdef MADV_HUGEPAGE
+    if (OPTIONS & backing_thp)
+      ::madvise(ptr, size, MADV_HUGEPAGE);
+#endif
+
+    if (OPTIONS & backing_prefault) {
+      std::size_t page = static_cast<std::size_t>(::sysconf(_SC_PAGESIZE));
+      volatile unsigned char *bytes_ptr = static_cast<unsigned char *>(ptr);
+      for (std::size_t off = 0; off < size; off += page)
+        bytes_ptr[off] = 0;
+    }
+
+    if (OPTIONS & backing_lock)
+      ::mlock(ptr, size);
+
+    return ptr;
+  }
+
+  /**
+   * @brief Release the block.
+   * @param ptr [in] - pointer to the block.
+   * @param bytes [in] - size of the block, the same as on the allocation.
+   */
+  static void release(void *ptr, std::size_t bytes, std::size_t) {
+    if (ptr != nullptr)
+      ::munmap(ptr, map_size(bytes));
+  }
+
+
+  private:
+    /**
+     * @brief Size of the mapping.
+     *
+     * The same size is mapped with the normal pages when the huge pages are
+     * not available, so the release does not need to know which one is used.
+     * @param bytes [in] - size of the block.
+     * @return size rounded up to the page.
+     */
+    static std::size_t map_size(std::size_t bytes) {
+      std::size_t page = (OPTIONS & backing_hugetlb)
+          ? HUGE_PAGE : static_cast<std::size_t>(::sysconf(_SC_PAGESIZE));
+      return (bytes + page - 1) / page * page;
+    }
+#else
+  static void * alloc(std::size_t bytes, std::size_t align) {
+    return heap_backing::alloc(bytes, align);
+  }
+
+  static void release(void *ptr, std::size_t bytes, std::size_t align) {
+    heap_backing::release(ptr, bytes, align);
+  }
+#endif /* BACKING_HAS_MMAP */
+};
+
+
+/**
+ * Discription of the allocator over the backing policy.
+ *
+ * The stateless allocator that takes every request from the policy, so the
+ * containers of the single blocks (flat_hash_map) get the system heap or the
+ * mapped pages by default and any other allocator when it is given.
+ * @tparam T - data types.
+ * @tparam BACKING - the backing policy. Default on heap_backing.
+ */
+template<typename T, typename BACKING = heap_backing>
+class backing_allocator
+{
+  public:
+    /* Aliases */
+    using value_type = T;
+    using pointer = T *;
+    using const_pointer = const T *;
+    using reference = T &;
+    using const_reference = const T &;
+    using is_always_equal = std::true_type;
+
+    template<typename U>
+    struct rebind {
+      using other = backing_allocator<U, BACKING>;
+    };
+
+    /* By default ... */
+    backing_allocator() = default;
+
+    /**
+     * @brief Constructor of the allocator of the other type, used by the
+     *        containers to rebind it.
+     */
+    template<typename U>
+    backing_allocator(const backing_allocator<U, BACKING> &)
+    {}
+
+    /**
+     * @brief allocation of a given "piece" of memory.
+     * @param n [in] - amount of memory requested.
+     * @return pointer to the allocated memory.
+     */
+    pointer allocate(std::size_t n) {
+      return static_cast<pointer>(BACKING::alloc(n * sizeof(T), alignof(T)));
+    }
+
+    /**
+     * @brief Release a specified amount of memory.
+     * @param p [in] - pointer to the beginning of the memory.
+     * @param n [in] - size of free memory.
+     */
+    void deallocate(pointer p, std::size_t n) {
+      BACKING::release(p, n * sizeof(T), alignof(T));
+    }
+};
+
+
+/**
+ * @brief Comparison operator.
+ * @return true, the memory of the policy is released by any allocator.
+ */
+template<typename T, typename U, typename BACKING>
+bool operator==(const backing_allocator<T, BACKING> &,
+                const backing_allocator<U, BACKING> &)
+{
+  return true;
+}
+
+/**
+ * @brief Inequality operator.
+ * @return false, see the comparison operator.
+ */
+template<typename T, typename U, typename BACKING>
+bool operator!=(const backing_allocator<T, BACKING> &,
+                const backing_allocator<U, BACKING> &)
+{
+  return false;
+}
+
+
+/**
+ * Discription of the check that the allocator is backing_allocator.
+ *
+ * @tparam A - the allocator.
+ */
+template<typename A>
+struct is_backing_allocator : std::false_type
+{};
+
+/**
+ * Discription of the check that the allocator is backing_allocator,
+ * specialization for backing_allocator.
+ *
+ * @tparam T - data types.
+ * @tparam BACKING - the backing policy.
+ */
+template<typename T, typename BACKING>
+struct is_backing_allocator<backing_allocator<T, BACKING>> : std::true_type
+{};
+
+#endif /* BACKINGPOLICY_HPP_ */
@@ -0,0 +1,704 @@
+/**
+ ******************************************************************************
+ * @file    benchmark.cpp
+ * @author  Maxim <aveter@bk.ru>
+ * @date    05/06/2019
+ * @brief   Benchmark of "Fixed Allocator" against std::allocator.
+ ******************************************************************************
+ */
+
+#include "arenaallocator.hpp"
+#include "blockmap.hpp"
+#include "concurrentallocator.hpp"
+#include "fixedallocator.hpp"
+#include "flathashmap.hpp"
+#include "inlineallocator.hpp"
+#include "monotonicarena.hpp"
+#include "mpscqueue.hpp"
+#include "nodelist.hpp"
+#include "parallel.hpp"
+#include "poolresource.hpp"
+#include "unrolledlist.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <list>
+#include <map>
+#include <memory_resource>
+#include <random>
+#include <string>
+#include <thread>
+#include <tuple>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+
+/**
+ * @brief The foo struct to test the complex type.
+ */
+struct foo
+{
+  foo(int a, float b)
+    : a(a), b(b)
+  {}
+
+  foo(const foo &) = delete;
+
+  int a;
+  float b;
+};
+
+
+/**
+ * The timings of the benchmark.
+ */
+struct samples
+{
+  std::vector<double> ns;   /**< - time of the operation in nanoseconds */
+};
+
+
+using bench_clock = std::chrono::steady_clock;
+
+volatile long sink = 0;   /**< - keeps the results from the optimizer. */
+
+
+/**
+ * @brief Time of the call in nanoseconds.
+ * @tparam F - the type of the function.
+ * @param f [in] - the function.
+ * @return the time.
+ */
+template<typename F>
+double time_ns(F &&f)
+{
+  auto start = bench_clock::now();
+  f();
+  auto stop = bench_clock::now();
+  return std::chrono::duration<double, std::nano>(stop - start).count();
+}
+
+
+/**
+ * @brief Print the result as the CSV line.
+ * @param bench [in] - name of the benchmark.
+ * @param container [in] - name of the container.
+ * @param alloc [in] - name of the allocator.
+ * @param type [in] - name of the value type.
+ * @param elements [in] - number of the elements.
+ * @param res [in] - the timings of one operation.
+ */
+void report(const std::string &bench, const std::string &container,
+            const std::string &alloc, const std::string &type,
+            std::size_t elements, samples &res)
+{
+  std::vector<double> &ns = res.ns;
+  if (ns.empty())
+    return;
+
+  std::sort(ns.begin(), ns.end());
+  double sum = 0;
+  for (double val: ns)
+    sum += val;
+
+  auto pct = [&ns](double p) {
+    return ns[static_cast<std::size_t>(p * (ns.size() - 1))];
+  };
+
+  std::cout << bench << ',' << container << ',' << alloc << ',' << type << ','
+            << elements << ',' << ns.size() << ',' << sum / ns.size() << ','
+            << pct(0.5) << ',' << pct(0.9) << ',' << pct(0.99) << std::endl;
+}
+
+
+/**
+ * @brief Check the result of the benchmark, the failure stops the program.
+ * @param ok [in] - the result is correct.
+ * @param what [in] - name of the checked result.
+ */
+void check(bool ok, const std::string &what)
+{
+  if (ok)
+    return;
+
+  std::cerr << "check failed: " << what << std::endl;
+  std::exit(EXIT_FAILURE);
+}
+
+
+/**
+ * @brief Construct the value of the test type.
+ */
+template<typename T>
+struct make_value;
+
+template<>
+struct make_value<int>
+{
+  static const char * name() { return "int"; }
+  static std::tuple<int> args(int i) { return std::make_tuple(i); }
+  static long key(const int &v) { return v; }
+};
+
+template<>
+struct make_value<foo>
+{
+  static const char * name() { return "foo"; }
+  static std::tuple<int, float> args(int i) { return std::make_tuple(i, 2.2f); }
+  static long key(const foo &v) { return v.a; }
+};
+
+
+/**
+ * @brief Allocation and deallocation of single objects.
+ * @tparam T - the type of the value.
+ * @tparam Alloc - the type of the allocator.
+ * @param alloc_name [in] - name of the allocator.
+ * @param elements [in] - number of the elements.
+ * @param rounds [in] - number of the rounds.
+ */
+template<typename T, typename Alloc>
+void bench_alloc(const std::string &alloc_name, std::size_t elements,
+                 std::size_t rounds)
+{
+  Alloc alloc;
+  std::vector<T *> ptrs(elements);
+  samples alloc_res, free_res;
+
+  for (std::size_t r = 0; r < rounds; ++r) {
+    alloc_res.ns.push_back(time_ns([&] {
+      for (std::size_t i = 0; i < elements; ++i)
+        ptrs[i] = alloc.allocate(1);
+    }) / elements);
+
+    /* free in the other order than allocated */
+    std::reverse(ptrs.begin(), ptrs.begin() + elements / 2);
+    free_res.ns.push_back(time_ns([&] {
+      for (std::size_t i = 0; i < elements; ++i)
+        alloc.deallocate(ptrs[i], 1);
+    }) / elements);
+  }
+
+  report("alloc", "raw", alloc_name, make_value<T>::name(), elements, alloc_res);
+  report("free", "raw", alloc_name, make_value<T>::name(), elements, free_res);
+}
+
+
+/**
+ * @brief Insert, lookup, iteration and erase of the map.
+ * @tparam M - the type of the map.
+ * @tparam T - the type of the value.
+ * @param container [in] - name of the container.
+ * @param alloc_name [in] - name of the allocator.
+ * @param elements [in] - number of the elements.
+ * @param rounds [in] - number of the rounds.
+ */
+template<typename M, typename T>
+void bench_map(const std::string &container, const std::string &alloc_name,
+               std::size_t elements, std::size_t rounds)
+{
+  samples ins_res, find_res, iter_res, erase_res;
+
+  std::vector<int> keys(elements);
+  for (std::size_t i = 0; i < elements; ++i)
+    keys[i] = static_cast<int>(i);
+  std::mt19937 gen(1);
+  std::shuffle(keys.begin(), keys.end(), gen);
+
+  for (std::size_t r = 0; r < rounds; ++r) {
+    M map;
+    for (int key: keys)
+      ins_res.ns.push_back(time_ns([&] {
+        std::apply([&](auto &&... args) {
+          map.try_emplace(key, std::forward<decltype(args)>(args)...);
+        }, make_value<T>::args(key));
+      }));
+
+    for (int key: keys)
+      find_res.ns.push_back(time_ns([&] {
+        sink += map.find(key)->first;
+      }));
+
+    iter_res.ns.push_back(time_ns([&] {
+      long sum = 0;
+      for (auto &p: map)
+        sum += make_value<T>::key(p.second);
+      sink += sum;
+    }) / elements);
+
+    for (int key: keys)
+      erase_res.ns.push_back(time_ns([&] {
+        map.erase(key);
+      }));
+  }
+
+  const char *type = make_value<T>::name();
+  report("insert", container, alloc_name, type, elements, ins_res);
+  report("lookup", container, alloc_name, type, elements, find_res);
+  report("iterate", container, alloc_name, type, elements, iter_res);
+  report("erase", container, alloc_name, type, elements, erase_res);
+}
+
+
+/**
+ * @brief Constructor of the value from the tuple of the arguments.
+ */
+template<typename L, typename Tuple, std::size_t... I>
+void emplace_back_tuple(L &list, Tuple &&args, std::index_sequence<I...>)
+{
+  list.emplace_back(std::get<I>(std::forward<Tuple>(args))...);
+}
+
+
+/**
+ * @brief Insert, iteration and erase of the list.
+ * @tparam L - the type of the list.
+ * @tparam T - the type of the value.
+ * @param container [in] - name of the container.
+ * @param alloc_name [in] - name of the allocator.
+ * @param elements [in] - number of the elements.
+ * @param rounds [in] - number of the rounds.
+ */
+template<typename L, typename T>
+void bench_list(const std::string &container, const std::string &alloc_name,
+                std::size_t elements, std::size_t rounds)
+{
+  samples ins_res, iter_res, erase_res;
+  using args_t = decltype(make_value<T>::args(0));
+
+  for (std::size_t r = 0; r < rounds; ++r) {
+    L list;
+    for (std::size_t i = 0; i < elements; ++i)
+      ins_res.ns.push_back(time_ns([&] {
+        emplace_back_tuple(list, make_value<T>::args(static_cast<int>(i)),
+                           std::make_index_sequence<
+                             std::tuple_size<args_t>::value>());
+      }));
+
+    iter_res.ns.push_back(time_ns([&] {
+      long sum = 0;
+      for (auto &val: list)
+        sum += make_value<T>::key(val);
+      sink += sum;
+    }) / elements);
+
+    for (std::size_t i = 0; i < elements; ++i)
+      erase_res.ns.push_back(time_ns([&] {
+        list.pop_front();
+      }));
+  }
+
+  const char *type = make_value<T>::name();
+  report("insert", container, alloc_name, type, elements, ins_res);
+  report("iterate", container, alloc_name, type, elements, iter_res);
+  report("erase", container, alloc_name, type, elements, erase_res);
+}
+
+
+/**
+ * @brief Iteration of the list scattered in the pool before and after the
+ *        compaction.
+ *
+ * The list is scattered by the churn in its own pool: the random half of the
+ * items is erased and the new items take the released cells in the order of
+ * the free list.
+ * @tparam ELEMENTS - number of the elements.
+ * @param rounds [in] - number of the rounds.
+ */
+template<std::size_t ELEMENTS>
+void bench_compact(std::size_t rounds)
+{
+  using list_t = node_list<int, fixed_allocator<int, ELEMENTS * 2>>;
+  samples before_res, after_res, compact_res;
+  std::mt19937 gen(1);
+
+  for (std::size_t r = 0; r < rounds; ++r) {
+    list_t list;
+    for (std::size_t i = 0; i < ELEMENTS; ++i)
+      list.push_back(static_cast<int>(i));
+
+    while (!list.empty() && gen() % 2)
+      list.pop_front();
+    for (auto pos = list.begin(); pos != list.end(); ) {
+      auto next = pos;
+      if (++next == list.end())
+        break;
+      if (gen() % 2)
+        list.erase_after(pos);
+      else
+        pos = next;
+    }
+    for (std::size_t i = list.size(); i < ELEMENTS; ++i) {
+      if (gen() % 2)
+        list.push_front(static_cast<int>(i));
+      else
+        list.push_back(static_cast<int>(i));
+    }
+
+    auto iterate = [&list] {
+      long sum = 0;
+      for (int val: list)
+        sum += val;
+      sink += sum;
+    };
+
+    before_res.ns.push_back(time_ns(iterate) / ELEMENTS);
+    compact_res.ns.push_back(time_ns([&list] {
+      list.compact();
+    }) / ELEMENTS);
+    after_res.ns.push_back(time_ns(iterate) / ELEMENTS);
+  }
+
+  report("iterate_scattered", "node_list", "fixed_allocator", "int", ELEMENTS,
+         before_res);
+  report("compact", "node_list", "fixed_allocator", "int", ELEMENTS,
+         compact_res);
+  report("iterate_compacted", "node_list", "fixed_allocator", "int", ELEMENTS,
+         after_res);
+}
+
+
+/**
+ * @brief Allocation in several threads and deallocation in the other ones
+ *        with the shared pool.
+ *
+ * Every thread fills its objects, then every thread checks and frees the
+ * objects of its neighbour, so the cells go back to the pool through the
+ * magazines of the other threads.
+ * @tparam THREADS - number of the threads.
+ * @tparam ELEMENTS - number of the elements of every thread.
+ * @param rounds [in] - number of the rounds.
+ */
+template<std::size_t THREADS, std::size_t ELEMENTS>
+void bench_concurrent(std::size_t rounds)
+{
+  using alloc_t = concurrent_allocator<long, THREADS * (ELEMENTS + 64)>;
+  std::vector<std::vector<long *>> ptrs(THREADS, std::vector<long *>(ELEMENTS));
+  samples res;
+
+  auto run = [](std::size_t count, auto work) {
+    std::vector<std::thread> threads;
+    for (std::size_t t = 0; t < count; ++t)
+      threads.emplace_back(work, t);
+    for (std::thread &thr: threads)
+      thr.join();
+  };
+
+  for (std::size_t r = 0; r < rounds; ++r) {
+    std::atomic<std::size_t> errors{0};
+
+    res.ns.push_back(time_ns([&] {
+      run(THREADS, [&ptrs](std::size_t t) {
+        alloc_t alloc;
+        for (std::size_t i = 0; i < ELEMENTS; ++i) {
+          ptrs[t][i] = alloc.allocate(1);
+          alloc.construct(ptrs[t][i], static_cast<long>(t * ELEMENTS + i));
+        }
+      });
+      run(THREADS, [&ptrs, &errors](std::size_t t) {
+        alloc_t alloc;
+        std::size_t owner = (t + 1) % THREADS;
+        for (std::size_t i = 0; i < ELEMENTS; ++i) {
+          if (*ptrs[owner][i] != static_cast<long>(owner * ELEMENTS + i))
+            ++errors;
+          alloc.deallocate(ptrs[owner][i], 1);
+        }
+      });
+    }) / (THREADS * ELEMENTS));
+
+    check(errors == 0, "concurrent_allocator keeps the values");
+  }
+
+  report("alloc_free_mt", "raw", "concurrent_allocator", "long",
+         THREADS * ELEMENTS, res);
+}
+
+
+/**
+ * @brief The containers of the different types sharing one arena.
+ *
+ * The map and the list take the memory from the same arena, the results are
+ * checked by the test target.
+ * @tparam ELEMENTS - number of the elements.
+ * @param rounds [in] - number of the rounds.
+ */
+template<std::size_t ELEMENTS>
+void bench_arena(std::size_t rounds)
+{
+  /* the node of the map is in the class of 4 units */
+  using arena_t = fixed_arena<ELEMENTS * 4>;
+  using map_t = std::map<int, long, std::less<int>,
+                         arena_allocator<std::pair<const int, long>, arena_t>>;
+  using list_t = node_list<long, arena_allocator<long, arena_t>>;
+  samples res;
+
+  for (std::size_t r = 0; r < rounds; ++r) {
+    auto arena = std::make_shared<arena_t>();
+    map_t map{std::less<int>(), typename map_t::allocator_type(arena)};
+    list_t list{arena_allocator<long, arena_t>(arena)};
+
+    res.ns.push_back(time_ns([&] {
+      for (std::size_t i = 0; i < ELEMENTS; ++i) {
+        map.emplace(static_cast<int>(i), static_cast<long>(i));
+        list.push_front(static_cast<long>(i));
+      }
+    }) / (2 * ELEMENTS));
+  }
+
+  report("insert", "std::map+node_list", "arena_allocator", "long", ELEMENTS,
+         res);
+}
+
+
+/**
+ * @brief The list built for one request in the monotonic arena.
+ *
+ * The list is built and dropped in every round, the arena is reset and its
+ * blocks are reused; the results are checked by the test target.
+ * @tparam ELEMENTS - number of the elements.
+ * @param rounds [in] - number of the rounds.
+ */
+template<std::size_t ELEMENTS>
+void bench_monotonic(std::size_t rounds)
+{
+  using arena_t = monotonic_arena<4096>;
+  using list_t = node_list<long, monotonic_allocator<long, arena_t>>;
+  arena_t arena;
+  samples res;
+
+  for (std::size_t r = 0; r < rounds; ++r) {
+    long sum = 0;
+
+    res.ns.push_back(time_ns([&] {
+      list_t list{monotonic_allocator<long, arena_t>(arena)};
+      for (std::size_t i = 0; i < ELEMENTS; ++i)
+        list.push_back(static_cast<long>(i));
+      for (long val: list)
+        sum += val;
+    }) / ELEMENTS);
+    arena.reset();
+    sink += sum;
+  }
+
+  report("build_drop", "node_list", "monotonic_allocator", "long", ELEMENTS,
+         res);
+}
+
+
+/**
+ * @brief The parallel reduction of the list against the serial one.
+ *
+ * The results are checked by the test target.
+ * @tparam ELEMENTS - number of the elements.
+ * @param rounds [in] - number of the rounds.
+ */
+template<std::size_t ELEMENTS>
+void bench_parallel(std::size_t rounds)
+{
+  node_list<long, fixed_allocator<long, ELEMENTS>> list;
+  for (std::size_t i = 0; i < ELEMENTS; ++i)
+    list.push_back(static_cast<long>(i));
+
+  thread_pool pool(4);
+  auto segments = make_segments(pool, list);
+  auto square = [](long val) { return val * val; };
+  samples serial_res, parallel_res;
+
+  for (std::size_t r = 0; r < rounds; ++r) {
+    long serial = 0, parallel = 0;
+
+    serial_res.ns.push_back(time_ns([&] {
+      for (long val: list)
+        serial += square(val);
+    }) / ELEMENTS);
+    parallel_res.ns.push_back(time_ns([&] {
+      parallel = parallel_transform_reduce(pool, segments, 0L,
+                                           std::plus<long>(), square);
+    }) / ELEMENTS);
+    sink += serial + parallel;
+  }
+
+  report("sum_serial", "node_list", "fixed_allocator", "long", ELEMENTS,
+         serial_res);
+  report("sum_parallel", "node_list", "fixed_allocator", "long", ELEMENTS,
+         parallel_res);
+}
+
+
+/**
+ * @brief The std::pmr list on the pool resource against the default one.
+ *
+ * The items are inserted and erased, the results are checked by the test
+ * target.
+ * @tparam ELEMENTS - number of the elements.
+ * @param rounds [in] - number of the rounds.
+ */
+template<std::size_t ELEMENTS>
+void bench_pool_resource(std::size_t rounds)
+{
+  pool_resource<fixed_arena<ELEMENTS>> pool;
+
+  auto run = [rounds](const std::string &name,
+                      std::pmr::memory_resource *resource) {
+    samples res;
+
+    for (std::size_t r = 0; r < rounds; ++r) {
+      std::pmr::list<long> list(resource);
+      res.ns.push_back(time_ns([&list] {
+        for (std::size_t i = 0; i < ELEMENTS; ++i)
+          list.push_back(static_cast<long>(i));
+        list.remove_if([](long val) { return val % 2 != 0; });
+      }) / ELEMENTS);
+
+      for (long val: list)
+        sink += val;
+    }
+
+    report("insert_erase", "std::pmr::list", name, "long", ELEMENTS, res);
+  };
+
+  run("default_resource", std::pmr::get_default_resource());
+  run("pool_resource", &pool);
+}
+
+
+/**
+ * @brief The hand-off of the messages from several producers to one consumer.
+ *
+ * The order of the messages is checked by the test target.
+ * @tparam THREADS - number of the producers.
+ * @tparam ELEMENTS - number of the messages of every producer, all of them
+ *                    fit the pool of the queue.
+ * @param rounds [in] - number of the rounds.
+ */
+template<std::size_t THREADS, std::size_t ELEMENTS>
+void bench_mpsc(std::size_t rounds)
+{
+  samples res;
+
+  for (std::size_t r = 0; r < rounds; ++r) {
+    mpsc_queue<long> queue;
+
+    res.ns.push_back(time_ns([&] {
+      std::vector<std::thread> producers;
+      for (std::size_t t = 0; t < THREADS; ++t)
+        producers.emplace_back([&queue, t] {
+          for (std::size_t i = 0; i < ELEMENTS; ++i)
+            queue.push(static_cast<long>(t * ELEMENTS + i));
+        });
+
+      long msg;
+      for (std::size_t received = 0; received < THREADS * ELEMENTS; ) {
+        if (!queue.try_pop(msg))
+          continue;
+
+        sink += msg;
+        ++received;
+      }
+
+      for (std::thread &thr: producers)
+        thr.join();
+    }) / (THREADS * ELEMENTS));
+  }
+
+  report("push_pop_mt", "mpsc_queue", "concurrent_allocator", "long",
+         THREADS * ELEMENTS, res);
+}
+
+
+/**
+ * @brief All the benchmarks for the value type and the number of elements.
+ * @tparam T - the type of the value.
+ * @tparam ELEMENTS - number of the elements.
+ * @param rounds [in] - number of the rounds.
+ */
+template<typename T, std::size_t ELEMENTS>
+void bench_all(std::size_t rounds)
+{
+  using map_value_t = std::pair<const int, T>;
+  using std_map_t = std::map<int, T>;
+  using fixed_map_t = std::map<int, T, std::less<int>,
+                               fixed_allocator<map_value_t, ELEMENTS>>;
+  using growth_map_t = std::map<int, T, std::less<int>,
+                                fixed_allocator<map_value_t, 64,
+                                                geometric_growth<>>>;
+
+  bench_alloc<T, std::allocator<T>>("std::allocator", ELEMENTS, rounds);
+  bench_alloc<T, fixed_allocator<T, ELEMENTS>>("fixed_allocator", ELEMENTS,
+                                               rounds);
+  bench_alloc<T, fixed_allocator<T, 64, geometric_growth<>>>(
+                      "fixed_allocator_growth", ELEMENTS, rounds);
+  bench_alloc<T, fixed_allocator<T, ELEMENTS, no_growth,
+                                 mmap_backing<backing_thp | backing_prefault>>>(
+                      "fixed_allocator_mmap", ELEMENTS, rounds);
+
+  bench_map<std_map_t, T>("std::map", "std::allocator", ELEMENTS, rounds);
+  bench_map<fixed_map_t, T>("std::map", "fixed_allocator", ELEMENTS, rounds);
+  bench_map<growth_map_t, T>("std::map", "fixed_allocator_growth", ELEMENTS,
+                             rounds);
+  bench_map<std::unordered_map<int, T>, T>("std::unordered_map",
+                                           "std::allocator", ELEMENTS, rounds);
+
+  /* the items of the block map and the hash map are moved, foo is not
+     movable */
+  if constexpr (std::is_move_constructible<T>::value) {
+    bench_map<block_map<int, T>, T>("block_map", "std::allocator", ELEMENTS,
+                                    rounds);
+    bench_map<block_map<int, T, std::less<int>,
+                        fixed_allocator<map_value_t, ELEMENTS / 16 + 2,
+                                        linear_growth>>, T>(
+                        "block_map", "fixed_allocator", ELEMENTS, rounds);
+    bench_map<flat_hash_map<int, T>, T>("flat_hash_map", "backing_allocator",
+                                        ELEMENTS, rounds);
+  }
+
+  bench_list<node_list<T>, T>("node_list", "std::allocator", ELEMENTS, rounds);
+  bench_list<node_list<T, fixed_allocator<T, ELEMENTS>>, T>(
+                      "node_list", "fixed_allocator", ELEMENTS, rounds);
+  bench_list<node_list<T, fixed_allocator<T, 64, geometric_growth<>>>, T>(
+                      "node_list", "fixed_allocator_growth", ELEMENTS, rounds);
+
+  bench_list<unrolled_list<T>, T>("unrolled_list", "std::allocator", ELEMENTS,
+                                  rounds);
+  bench_list<unrolled_list<T, 16, fixed_allocator<T, ELEMENTS>>, T>(
+                      "unrolled_list", "fixed_allocator", ELEMENTS, rounds);
+}
+
+
+/**
+ * @brief Main function / entry point.
+ *
+ * Prints the results in CSV: the time of one operation in nanoseconds, the
+ * mean and the percentiles. The optional argument is the number of rounds.
+ */
+int main(int argc, char *argv[]) {
+  std::size_t rounds = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 5;
+  if (rounds == 0)
+    rounds = 1;
+
+  std::cout << "benchmark,container,allocator,value_type,elements,samples,"
+               "mean_ns,p50_ns,p90_ns,p99_ns" << std::endl;
+
+  bench_all<int, 100>(rounds);
+  bench_list<node_list<int, inline_allocator<int, 100>>, int>(
+                      "node_list", "inline_allocator", 100, rounds);
+  bench_all<int, 10000>(rounds);
+  bench_all<int, 100000>(rounds);
+  bench_compact<100000>(rounds);
+  bench_concurrent<4, 100000>(rounds);
+  bench_arena<10000>(rounds);
+  bench_monotonic<100000>(rounds);
+  bench_parallel<1000000>(rounds);
+  bench_pool_resource<100000>(rounds);
+  bench_mpsc<4, 10000>(rounds);
+  bench_all<foo, 100>(rounds);
+  bench_all<foo, 10000>(rounds);
+  bench_all<foo, 100000>(rounds);
+
+  return 0;
+}
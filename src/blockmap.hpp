@@ -0,0 +1,977 @@
+/**
+ ******************************************************************************
+ * @file    blockmap.hpp
+ * @author  Maxim <aveter@bk.ru>
+ * @date    25/06/2019
+ * @brief   Description of the template "Block Map".
+ ******************************************************************************
+ */
+
+#ifndef BLOCKMAP_HPP_
+#define BLOCKMAP_HPP_
+
+#include <cstddef>
+#include <functional>
+#include <iterator>
+#include <memory>
+#include <new>
+#include <stdexcept>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+
+/* Forward ad */
+template<typename K, typename V, typename C, typename A, std::size_t N>
+class block_map;
+
+
+/**
+ * Discription of the leaf of the block map.
+ *
+ * The leaf keeps up to N sorted items in the contiguous array, the items
+ * occupy the cells [0, count).
+ * @tparam K - the type of the key.
+ * @tparam V - the type of the value.
+ * @tparam N - number of the cells in the leaf.
+ */
+template<typename K, typename V, std::size_t N>
+struct map_leaf
+{
+  using item_t = std::pair<const K, V>;
+
+  map_leaf *next;         /**< - next leaf in the order of the keys. */
+  std::size_t count;      /**< - number of the occupied cells. */
+
+  alignas(item_t) unsigned char items[N * sizeof(item_t)];  /**< - cells */
+
+  /**
+   * Constructor of the empty leaf.
+   */
+  map_leaf()
+    : next(nullptr), count(0)
+  {}
+
+  /**
+   * @brief Access to the cell.
+   * @param idx [in] - index of the cell.
+   * @return pointer to the item.
+   */
+  item_t * at(std::size_t idx) {
+    return std::launder(reinterpret_cast<item_t *>(items) + idx);
+  }
+};
+
+
+/**
+ * Discription of the inner node of the block map.
+ *
+ * The node keeps up to N children and the keys between them: the keys of the
+ * child idx are less than the key idx, the keys of the child idx + 1 are not
+ * less than it. One more child is kept for the overflow before the split.
+ * @tparam K - the type of the key.
+ * @tparam N - number of the children in the node.
+ */
+template<typename K, std::size_t N>
+struct map_inner
+{
+  std::size_t count;        /**< - number of the children. */
+  void *children[N + 1];    /**< - the inner nodes or the leaves. */
+
+  alignas(K) unsigned char keys[N * sizeof(K)];  /**< - keys [0, count - 1) */
+
+  /**
+   * Constructor of the empty node.
+   */
+  map_inner()
+    : count(0)
+  {}
+
+  /**
+   * @brief Access to the key.
+   * @param idx [in] - index of the key.
+   * @return pointer to the key.
+   */
+  K * key(std::size_t idx) {
+    return std::launder(reinterpret_cast<K *>(keys) + idx);
+  }
+};
+
+
+/**
+ * Discription of an iterator for working with the block map.
+ *
+ * @tparam K - the type of the key.
+ * @tparam V - the type of the value.
+ * @tparam N - number of the cells in the leaf.
+ * @tparam P - the type of the access to the item: const pair for the constant
+ *             iterator, pair for the mutable one.
+ */
+template<typename K, typename V, std::size_t N, typename P>
+class block_map_iterator
+{
+  public:
+    /* Aliases */
+    using iterator_category = std::forward_iterator_tag;
+    using value_type = std::pair<const K, V>;
+    using difference_type = std::ptrdiff_t;
+    using pointer = P *;
+    using reference = P &;
+
+    /**
+     * @brief Constructor with param.
+     * @param p [in] - pointer to the leaf. Default p = nullptr.
+     * @param idx [in] - index of the cell in the leaf.
+     */
+    block_map_iterator(map_leaf<K, V, N> *p = nullptr, std::size_t idx = 0)
+      : ptr_(p), idx_(idx)
+    {}
+
+    /**
+     * @brief Conversion of the mutable iterator to the constant one.
+     * @param other [in] - mutable iterator.
+     */
+    template<typename U, typename = typename std::enable_if<
+                           std::is_same<U, value_type>::value &&
+                           std::is_const<P>::value>::type>
+    block_map_iterator(const block_map_iterator<K, V, N, U> &other)
+      : ptr_(other.ptr_), idx_(other.idx_)
+    {}
+
+    /**
+     * @brief Inequality operator.
+     * @param  other [in] - iterator.
+     * @return true if the iterators are not equal and false otherwise.
+     */
+    bool operator!=(block_map_iterator const &other) const {
+      return ptr_ != other.ptr_ || idx_ != other.idx_;
+    }
+
+    /**
+     * @brief Comparison operator.
+     * @param other [in] - iterator
+     * @return true if equal and false otherwise.
+     */
+    bool operator==(block_map_iterator const &other) const {
+      return !(*this != other);
+    }
+
+    /**
+     * @brief Dereference operator.
+     * @return reference on the item.
+     */
+    P & operator*() const {
+      return *ptr_->at(idx_);
+    }
+
+    /**
+     * @brief Pointer selector operator.
+     * @return pointer on the item.
+     */
+    P * operator->() const {
+      return ptr_->at(idx_);
+    }
+
+    /**
+     * @brief Increment operator.
+     * @return increment data.
+     */
+    block_map_iterator & operator++() {
+      if (ptr_ && ++idx_ == ptr_->count) {
+        ptr_ = ptr_->next;
+        idx_ = 0;
+      }
+      return *this;
+    }
+
+    /**
+     * @brief Postfix increment operator.
+     * @return the iterator before the increment.
+     */
+    block_map_iterator operator++(int) {
+      block_map_iterator tmp(*this);
+      ++(*this);
+      return tmp;
+    }
+
+
+  private:
+    map_leaf<K, V, N> *ptr_{nullptr};   /**< - pointer to the leaf. */
+    std::size_t idx_ = 0;               /**< - index of the cell. */
+
+    /* Friends */
+    template<typename, typename, std::size_t, typename>
+    friend class block_map_iterator;
+};
+
+
+/**
+ * Swap the block map.
+ *
+ * @tparam Kt - the type of the key.
+ * @tparam Vt - the type of the value.
+ * @tparam Cmp - the comparator of the keys.
+ * @tparam Aloc - allocator, memory manager for working with container.
+ * @tparam Sz - number of the cells in the leaf.
+ * @param dst [in] - receiving container.
+ * @param src [out] - source container.
+ */
+template<typename Kt, typename Vt, typename Cmp, typename Aloc, std::size_t Sz>
+void swap(block_map<Kt, Vt, Cmp, Aloc, Sz> &dst,
+          block_map<Kt, Vt, Cmp, Aloc, Sz> &src)
+{
+  std::swap(dst.size_, src.size_);
+  std::swap(dst.height_, src.height_);
+  std::swap(dst.root_, src.root_);
+  std::swap(dst.first_, src.first_);
+  std::swap(dst.comp_, src.comp_);
+  std::swap(dst.allocator, src.allocator);
+  std::swap(dst.inner_allocator, src.inner_allocator);
+}
+
+
+/**
+ * Discription of the container "Block Map".
+ *
+ * The ordered map where the sorted items are kept in the leaves of N items,
+ * the leaves are the bottom of the B+ tree: the inner nodes keep up to N
+ * children and the keys between them. The lookup is the binary search in the
+ * contiguous keys of one node per level and then in the leaf, so it reads
+ * several cache lines instead of the chain of the tree nodes, and the
+ * in-order scan reads the leaves one after another.
+ *
+ * The leaves and the inner nodes are allocated one by one with the allocator
+ * rebound to their types, so all the memory of the map is taken from "Fixed
+ * Allocator" or "Arena Allocator". The full node is split in two and the key
+ * is added to the parent, the node less than half full takes the item from
+ * the neighbour or is merged with it. So the insertion and the erasure move
+ * at most N cells of one node per level, there are log(size) / log(N / 2)
+ * levels at most, and the inner nodes take about one key and one pointer per
+ * leaf. The iterators are invalidated by the insertion and the erasure, V
+ * must be movable.
+ * @tparam K - the type of the key.
+ * @tparam V - the type of the value.
+ * @tparam C - the comparator of the keys. Default on std::less<K>.
+ * @tparam A - allocator, memory manager for working with container. Default on
+ *             std::allocator.
+ * @tparam N - number of the items in the leaf and of the children of the inner
+ *             node. Default on 32.
+ */
+template<typename K, typename V, typename C = std::less<K>,
+         typename A = std::allocator<std::pair<const K, V>>,
+         std::size_t N = 32>
+class block_map
+{
+  static_assert(N > 2, "The node must keep at least three items");
+
+  public:
+    /* Aliases */
+    using key_type = K;
+    using mapped_type = V;
+    using value_type = std::pair<const K, V>;
+    using leaf_t = map_leaf<K, V, N>;
+    using inner_t = map_inner<K, N>;
+    using allocator_t =
+            typename std::allocator_traits<A>::template rebind_alloc<leaf_t>;
+    using inner_allocator_t =
+            typename std::allocator_traits<A>::template rebind_alloc<inner_t>;
+    using iterator_t = block_map_iterator<K, V, N, value_type>;
+    using const_iterator_t = block_map_iterator<K, V, N, const value_type>;
+
+    /**
+     * The default constructor.
+     */
+    block_map() = default;
+
+    /**
+     * @brief Constructor with the comparator and the memory manager.
+     * @param comp [in] - the comparator of the keys.
+     * @param alloc [in] - allocator, is rebound to the node types.
+     */
+    explicit block_map(const C &comp, const A &alloc = A())
+      : comp_(comp), allocator(alloc), inner_allocator(alloc)
+    {}
+
+    /**
+     * The distructor
+     */
+    virtual ~block_map() {
+      clear();
+    }
+
+    /**
+     * @brief Copy constructor.
+     * @param other [in] - the object to copy.
+     */
+    block_map(const block_map &other)
+      : comp_(other.comp_),
+        allocator(static_cast<const allocator_t &>(
+                    std::allocator_traits<allocator_t>::
+                      select_on_container_copy_construction(other.allocator))),
+        inner_allocator(static_cast<const inner_allocator_t &>(
+                          std::allocator_traits<inner_allocator_t>::
+                            select_on_container_copy_construction(
+                              other.inner_allocator))) {
+      for (const value_type &item: other)
+        try_emplace(item.first, item.second);
+    }
+
+    /**
+     * @brief Move constructor.
+     * @param other [in] - the object to move.
+     */
+    block_map(block_map &&other)
+      : size_(other.size_), height_(other.height_), root_(other.root_),
+        first_(other.first_), comp_(other.comp_),
+        allocator(std::move(other.allocator)),
+        inner_allocator(std::move(other.inner_allocator)) {
+      other.size_ = 0;
+      other.height_ = 0;
+      other.root_ = nullptr;
+      other.first_ = nullptr;
+    }
+
+    /**
+     * @brief Copy operator.
+     * @param other [in] - the object to copy.
+     */
+    block_map & operator=(const block_map &other) {
+      if (this != &other) {
+        clear();
+        for (const value_type &item: other)
+          try_emplace(item.first, item.second);
+      }
+      return *this;
+    }
+
+    /**
+     * @brief Move operator.
+     * @param other [in] - the object to move.
+     */
+    block_map & operator=(block_map &&other) {
+      swap(*this, other);
+      return *this;
+    }
+
+    /**
+     * @brief  The begin iterator of the map.
+     * @return Returns an iterator to the smallest key.
+     */
+    iterator_t begin() {
+      return iterator_t(first_, 0);
+    }
+
+    /**
+     * @brief  The end iterator of the map.
+     * @return Returns an iterator to the end of the map.
+     */
+    iterator_t end() {
+      return iterator_t();
+    }
+
+    /**
+     * @brief  The begin iterator of the constant map.
+     * @return Returns an const iterator to the smallest key.
+     */
+    const_iterator_t begin() const {
+      return cbegin();
+    }
+
+    /**
+     * @brief  The end iterator of the constant map.
+     * @return Returns an const iterator to the end of the map.
+     */
+    const_iterator_t end() const {
+      return cend();
+    }
+
+    /**
+     * @brief  The const begin iterator of the map.
+     * @return Returns an const iterator to the smallest key.
+     */
+    const_iterator_t cbegin() const {
+      return const_iterator_t(first_, 0);
+    }
+
+    /**
+     * @brief  The const end iterator of the map.
+     * @return Returns an const iterator to the end of the map.
+     */
+    const_iterator_t cend() const { return const_iterator_t(); }
+
+    /**
+     * @brief The number of items in the map.
+     * @return The number of items.
+     */
+    std::size_t size() const {
+      return size_;
+    }
+
+    /**
+     * @brief Check that the map has no items.
+     * @return true if the map is empty, otherwise false.
+     */
+    bool empty() const {
+      return size_ == 0;
+    }
+
+    /**
+     * @brief Find the item.
+     * @param key [in] - the key.
+     * @return iterator to the item or end().
+     */
+    iterator_t find(const K &key) {
+      if (root_ == nullptr)
+        return end();
+
+      leaf_t *leaf = descend(key, nullptr);
+      std::size_t pos = search(leaf, key);
+      if (pos < leaf->count && !comp_(key, leaf->at(pos)->first))
+        return iterator_t(leaf, pos);
+      return end();
+    }
+
+    /**
+     * @brief Find the item.
+     * @param key [in] - the key.
+     * @return const iterator to the item or end().
+     */
+    const_iterator_t find(const K &key) const {
+      return const_cast<block_map *>(this)->find(key);
+    }
+
+    /**
+     * @brief The first item with the key not less than the given one.
+     * @param key [in] - the key.
+     * @return iterator to the item or end().
+     */
+    iterator_t lower_bound(const K &key) {
+      if (root_ == nullptr)
+        return end();
+
+      leaf_t *leaf = descend(key, nullptr);
+      std::size_t pos = search(leaf, key);
+      if (pos < leaf->count)
+        return iterator_t(leaf, pos);
+      return iterator_t(leaf->next, 0);
+    }
+
+    /**
+     * @brief Number of the items with the key.
+     * @param key [in] - the key.
+     * @return 1 if the item exists, otherwise 0.
+     */
+    std::size_t count(const K &key) const {
+      return find(key) != end() ? 1 : 0;
+    }
+
+    /**
+     * @brief Access to the value, the item is added if there is no key.
+     * @param key [in] - the key.
+     * @return reference to the value.
+     */
+    V & operator[](const K &key) {
+      return try_emplace(key).first->second;
+    }
+
+    /**
+     * @brief Access to the value, std::out_of_range is thrown if there is no
+     *        key.
+     * @param key [in] - the key.
+     * @return reference to the value.
+     */
+    V & at(const K &key) {
+      iterator_t it = find(key);
+      if (it == end())
+        throw std::out_of_range("block_map::at");
+      return it->second;
+    }
+
+    /**
+     * @brief Add the copy of the item if there is no key.
+     * @param item [in] - the item.
+     * @return iterator to the item with the key and true if it is added.
+     */
+    std::pair<iterator_t, bool> insert(const value_type &item) {
+      return try_emplace(item.first, item.second);
+    }
+
+    /**
+     * @brief Construct the value if there is no key.
+     * @tparam ...Args - params.
+     * @param key [in] - the key.
+     * @param args [in] - constructor params of the value.
+     * @return iterator to the item with the key and true if it is added.
+     */
+    template<typename... Args>
+    std::pair<iterator_t, bool> try_emplace(const K &key, Args &&... args) {
+      path_t path;
+      leaf_t *leaf = nullptr;
+      std::size_t pos = 0;
+      if (root_ != nullptr) {
+        leaf = descend(key, &path);
+        pos = search(leaf, key);
+        if (pos < leaf->count && !comp_(key, leaf->at(pos)->first))
+          return {iterator_t(leaf, pos), false};
+      }
+
+      value_type item(std::piecewise_construct, std::forward_as_tuple(key),
+                      std::forward_as_tuple(std::forward<Args>(args)...));
+
+      if (leaf == nullptr) {
+        leaf = make_leaf();
+        root_ = first_ = leaf;
+      }
+      else if (leaf->count == N) {
+        split(path, leaf);
+        if (pos > N / 2) {
+          pos -= N / 2;
+          leaf = leaf->next;
+        }
+      }
+
+      for (std::size_t i = leaf->count; i > pos; --i)
+        relocate(leaf->at(i - 1), leaf->at(i));
+      ::new((void *) leaf->at(pos)) value_type(std::move(item));
+      ++leaf->count;
+      ++size_;
+      return {iterator_t(leaf, pos), true};
+    }
+
+    /**
+     * @brief Remove the item.
+     * @param key [in] - the key.
+     * @return number of the removed items.
+     */
+    std::size_t erase(const K &key) {
+      if (root_ == nullptr)
+        return 0;
+
+      path_t path;
+      leaf_t *leaf = descend(key, &path);
+      std::size_t pos = search(leaf, key);
+      if (pos == leaf->count || comp_(key, leaf->at(pos)->first))
+        return 0;
+
+      leaf->at(pos)->~value_type();
+      for (std::size_t i = pos + 1; i < leaf->count; ++i)
+        relocate(leaf->at(i), leaf->at(i - 1));
+      --leaf->count;
+      --size_;
+
+      rebalance(path, leaf);
+      return 1;
+    }
+
+    /**
+     * @brief Remove all the items.
+     */
+    void clear() {
+      if (root_ != nullptr)
+        drop_tree(root_, height_);
+      root_ = nullptr;
+      first_ = nullptr;
+      height_ = 0;
+      size_ = 0;
+    }
+
+
+  private:
+    /** The limit of the levels of the inner nodes. */
+    static constexpr std::size_t MAX_HEIGHT = 64;
+    /** The least number of the items in the leaf, except the root. */
+    static constexpr std::size_t LEAF_MIN = N / 2;
+    /** The least number of the children of the inner node, except the root. */
+    static constexpr std::size_t INNER_MIN = (N + 1) / 2;
+
+    /**
+     * The inner nodes from the root to the leaf and the indices of the
+     * children on the way.
+     */
+    struct path_t {
+      inner_t *nodes[MAX_HEIGHT];
+      std::size_t idx[MAX_HEIGHT];
+    };
+
+    std::size_t size_ = 0;          /**< - number of the items */
+    std::size_t height_ = 0;        /**< - levels of the inner nodes */
+    void *root_ = nullptr;          /**< - the root, the leaf if height_ = 0 */
+    leaf_t *first_ = nullptr;       /**< - the leaf with the smallest keys */
+    C comp_{};                      /**< - the comparator of the keys */
+    allocator_t allocator{};        /**< - memory manager of the leaves */
+    inner_allocator_t inner_allocator{}; /**< - memory manager of the inner
+                                              nodes */
+
+    /* Friends function */
+    template<typename Kt, typename Vt, typename Cmp, typename Aloc,
+             std::size_t Sz>
+    friend void swap(block_map<Kt, Vt, Cmp, Aloc, Sz> &dst,
+                     block_map<Kt, Vt, Cmp, Aloc, Sz> &src);
+
+    /**
+     * @brief The leaf which may keep the key, the map must not be empty.
+     * @param key [in] - the key.
+     * @param path [out] - the inner nodes on the way, nullptr if not needed.
+     * @return pointer to the leaf.
+     */
+    leaf_t * descend(const K &key, path_t *path) const {
+      void *node = root_;
+      for (std::size_t d = 0; d < height_; ++d) {
+        inner_t *inner = static_cast<inner_t *>(node);
+        std::size_t lo = 0;
+        std::size_t hi = inner->count - 1;
+        while (lo < hi) {
+          std::size_t mid = (lo + hi) / 2;
+          if (comp_(key, *inner->key(mid)))
+            hi = mid;
+          else
+            lo = mid + 1;
+        }
+        if (path != nullptr) {
+          path->nodes[d] = inner;
+          path->idx[d] = lo;
+        }
+        node = inner->children[lo];
+      }
+      return static_cast<leaf_t *>(node);
+    }
+
+    /**
+     * @brief Position of the first item with the key not less than the given
+     *        one.
+     * @param leaf [in] - the leaf.
+     * @param key [in] - the key.
+     * @return index of the cell, count if all the keys are less.
+     */
+    std::size_t search(leaf_t *leaf, const K &key) const {
+      std::size_t lo = 0;
+      std::size_t hi = leaf->count;
+      while (lo < hi) {
+        std::size_t mid = (lo + hi) / 2;
+        if (comp_(leaf->at(mid)->first, key))
+          lo = mid + 1;
+        else
+          hi = mid;
+      }
+      return lo;
+    }
+
+    /**
+     * @brief Move the upper half of the full leaf to the new leaf and add it
+     *        to the parent, the full parents are split too.
+     *
+     * All the new nodes are allocated before the change, so the map is kept
+     * if the allocation throws.
+     * @param path [in] - the inner nodes on the way to the leaf.
+     * @param leaf [in] - the full leaf.
+     */
+    void split(path_t &path, leaf_t *leaf) {
+      std::size_t full = 0;
+      while (full < height_ && path.nodes[height_ - 1 - full]->count == N)
+        ++full;
+      if (full == MAX_HEIGHT)
+        throw std::length_error("block_map::split");
+
+      const std::size_t taken = full < height_ ? full : full + 1;
+      inner_t *spare[MAX_HEIGHT];
+      std::size_t ready = 0;
+      leaf_t *new_leaf = make_leaf();
+      try {
+        for (; ready < taken; ++ready)
+          spare[ready] = make_inner();
+      }
+      catch (...) {
+        while (ready > 0)
+          drop_inner(spare[--ready]);
+        drop_leaf(new_leaf);
+        throw;
+      }
+
+      for (std::size_t i = N / 2; i < N; ++i)
+        relocate(leaf->at(i), new_leaf->at(i - N / 2));
+      new_leaf->count = N - N / 2;
+      leaf->count = N / 2;
+      new_leaf->next = leaf->next;
+      leaf->next = new_leaf;
+
+      K sep(new_leaf->at(0)->first);
+      void *child = new_leaf;
+      for (std::size_t d = height_; d > 0; --d) {
+        inner_t *node = path.nodes[d - 1];
+        insert_child(node, path.idx[d - 1] + 1, sep, child);
+        if (node->count <= N)
+          return;
+
+        inner_t *right = spare[--ready];
+        split_inner(node, right, sep);
+        child = right;
+      }
+
+      inner_t *root = spare[--ready];
+      ::new((void *) root->key(0)) K(std::move(sep));
+      root->children[0] = root_;
+      root->children[1] = child;
+      root->count = 2;
+      root_ = root;
+      ++height_;
+    }
+
+    /**
+     * @brief Move the upper half of the overflowed inner node to the new one.
+     * @param node [in] - the node with N + 1 children.
+     * @param right [in] - the empty node.
+     * @param sep [out] - the key between the nodes, to be added to the parent.
+     */
+    static void split_inner(inner_t *node, inner_t *right, K &sep) {
+      const std::size_t left = (N + 2) / 2;
+      sep = std::move(*node->key(left - 1));
+      node->key(left - 1)->~K();
+      for (std::size_t i = left; i < node->count; ++i) {
+        right->children[i - left] = node->children[i];
+        if (i + 1 < node->count)
+          relocate_key(node->key(i), right->key(i - left));
+      }
+      right->count = node->count - left;
+      node->count = left;
+    }
+
+    /**
+     * @brief Add the child to the inner node.
+     * @param node [in] - the node, it may overflow to N + 1 children.
+     * @param idx [in] - index of the new child, not 0.
+     * @param key [in] - the smallest key of the new child.
+     * @param child [in] - the new child.
+     */
+    static void insert_child(inner_t *node, std::size_t idx, const K &key,
+                             void *child) {
+      ::new((void *) node->key(node->count - 1)) K(key);
+      for (std::size_t i = node->count - 1; i >= idx; --i) {
+        std::swap(*node->key(i), *node->key(i - 1));
+        node->children[i + 1] = node->children[i];
+      }
+      node->children[idx] = child;
+      ++node->count;
+    }
+
+    /**
+     * @brief Remove the child and the key before it from the inner node.
+     * @param node [in] - the node.
+     * @param idx [in] - index of the child, not 0.
+     */
+    static void remove_child(inner_t *node, std::size_t idx) {
+      node->key(idx - 1)->~K();
+      for (std::size_t i = idx; i + 1 < node->count; ++i) {
+        relocate_key(node->key(i), node->key(i - 1));
+        node->children[i] = node->children[i + 1];
+      }
+      --node->count;
+    }
+
+    /**
+     * @brief Restore the leaf after the erasure: the leaf less than half
+     *        full takes the item from the neighbour or is merged with it.
+     * @param path [in] - the inner nodes on the way to the leaf.
+     * @param leaf [in] - the leaf.
+     */
+    void rebalance(path_t &path, leaf_t *leaf) {
+      if (height_ == 0) {
+        if (leaf->count == 0) {
+          drop_leaf(leaf);
+          root_ = nullptr;
+          first_ = nullptr;
+        }
+        return;
+      }
+      if (leaf->count >= LEAF_MIN)
+        return;
+
+      inner_t *parent = path.nodes[height_ - 1];
+      const std::size_t idx = path.idx[height_ - 1];
+      if (idx > 0) {
+        leaf_t *left = static_cast<leaf_t *>(parent->children[idx - 1]);
+        if (left->count > LEAF_MIN) {
+          for (std::size_t i = leaf->count; i > 0; --i)
+            relocate(leaf->at(i - 1), leaf->at(i));
+          relocate(left->at(--left->count), leaf->at(0));
+          ++leaf->count;
+          *parent->key(idx - 1) = leaf->at(0)->first;
+          return;
+        }
+      }
+      if (idx + 1 < parent->count) {
+        leaf_t *right = static_cast<leaf_t *>(parent->children[idx + 1]);
+        if (right->count > LEAF_MIN) {
+          relocate(right->at(0), leaf->at(leaf->count++));
+          for (std::size_t i = 1; i < right->count; ++i)
+            relocate(right->at(i), right->at(i - 1));
+          --right->count;
+          *parent->key(idx) = right->at(0)->first;
+          return;
+        }
+      }
+
+      const std::size_t li = idx > 0 ? idx - 1 : idx;
+      leaf_t *left = static_cast<leaf_t *>(parent->children[li]);
+      leaf_t *right = static_cast<leaf_t *>(parent->children[li + 1]);
+      for (std::size_t i = 0; i < right->count; ++i)
+        relocate(right->at(i), left->at(left->count + i));
+      left->count += right->count;
+      right->count = 0;
+      left->next = right->next;
+      drop_leaf(right);
+      remove_child(parent, li + 1);
+      rebalance_inner(path, height_ - 1);
+    }
+
+    /**
+     * @brief Restore the inner node after the merge of its children, the
+     *        same way as the leaf.
+     * @param path [in] - the inner nodes on the way to the leaf.
+     * @param d [in] - level of the node in the path.
+     */
+    void rebalance_inner(path_t &path, std::size_t d) {
+      inner_t *node = path.nodes[d];
+      if (d == 0) {
+        if (node->count == 1) {
+          root_ = node->children[0];
+          drop_inner(node);
+          --height_;
+        }
+        return;
+      }
+      if (node->count >= INNER_MIN)
+        return;
+
+      inner_t *parent = path.nodes[d - 1];
+      const std::size_t idx = path.idx[d - 1];
+      if (idx > 0) {
+        inner_t *left = static_cast<inner_t *>(parent->children[idx - 1]);
+        if (left->count > INNER_MIN) {
+          ::new((void *) node->key(node->count - 1)) K(*parent->key(idx - 1));
+          for (std::size_t i = node->count - 1; i > 0; --i)
+            std::swap(*node->key(i), *node->key(i - 1));
+          for (std::size_t i = node->count; i > 0; --i)
+            node->children[i] = node->children[i - 1];
+          node->children[0] = left->children[left->count - 1];
+          ++node->count;
+          *parent->key(idx - 1) = std::move(*left->key(left->count - 2));
+          left->key(left->count - 2)->~K();
+          --left->count;
+          return;
+        }
+      }
+      if (idx + 1 < parent->count) {
+        inner_t *right = static_cast<inner_t *>(parent->children[idx + 1]);
+        if (right->count > INNER_MIN) {
+          ::new((void *) node->key(node->count - 1)) K(*parent->key(idx));
+          node->children[node->count++] = right->children[0];
+          *parent->key(idx) = std::move(*right->key(0));
+          right->key(0)->~K();
+          for (std::size_t i = 1; i < right->count; ++i) {
+            if (i + 1 < right->count)
+              relocate_key(right->key(i), right->key(i - 1));
+            right->children[i - 1] = right->children[i];
+          }
+          --right->count;
+          return;
+        }
+      }
+
+      const std::size_t li = idx > 0 ? idx - 1 : idx;
+      inner_t *left = static_cast<inner_t *>(parent->children[li]);
+      inner_t *right = static_cast<inner_t *>(parent->children[li + 1]);
+      ::new((void *) left->key(left->count - 1)) K(*parent->key(li));
+      for (std::size_t i = 0; i < right->count; ++i) {
+        left->children[left->count + i] = right->children[i];
+        if (i + 1 < right->count)
+          relocate_key(right->key(i), left->key(left->count + i));
+      }
+      left->count += right->count;
+      right->count = 0;
+      drop_inner(right);
+      remove_child(parent, li + 1);
+      rebalance_inner(path, d - 1);
+    }
+
+    /**
+     * @brief Move the item to the free cell.
+     * @param from [in] - the item, it is destroyed.
+     * @param to [in] - the free cell.
+     */
+    static void relocate(value_type *from, value_type *to) {
+      ::new((void *) to) value_type(std::move(*from));
+      from->~value_type();
+    }
+
+    /**
+     * @brief Move the key to the free cell.
+     * @param from [in] - the key, it is destroyed.
+     * @param to [in] - the free cell.
+     */
+    static void relocate_key(K *from, K *to) {
+      ::new((void *) to) K(std::move(*from));
+      from->~K();
+    }
+
+    /**
+     * @brief Allocate and construct the empty leaf.
+     * @return pointer to the new leaf.
+     */
+    leaf_t * make_leaf() {
+      leaf_t *new_leaf = allocator.allocate(1);
+      ::new((void *) new_leaf) leaf_t();
+      return new_leaf;
+    }
+
+    /**
+     * @brief Deallocate the leaf, its items must be destroyed.
+     * @param ptr_leaf [in] - pointer to the leaf.
+     */
+    void drop_leaf(leaf_t *ptr_leaf) {
+      ptr_leaf->~leaf_t();
+      allocator.deallocate(ptr_leaf, 1);
+    }
+
+    /**
+     * @brief Allocate and construct the empty inner node.
+     * @return pointer to the new node.
+     */
+    inner_t * make_inner() {
+      inner_t *node = inner_allocator.allocate(1);
+      ::new((void *) node) inner_t();
+      return node;
+    }
+
+    /**
+     * @brief Destroy the keys and deallocate the inner node.
+     * @param node [in] - pointer to the node.
+     */
+    void drop_inner(inner_t *node) {
+      for (std::size_t i = 0; i + 1 < node->count; ++i)
+        node->key(i)->~K();
+      node->~inner_t();
+      inner_allocator.deallocate(node, 1);
+    }
+
+    /**
+     * @brief Destroy the items and deallocate the nodes of the subtree.
+     * @param node [in] - the root of the subtree.
+     * @param height [in] - levels of the inner nodes in the subtree.
+     */
+    void drop_tree(void *node, std::size_t height) {
+      if (height == 0) {
+        leaf_t *leaf = static_cast<leaf_t *>(node);
+        for (std::size_t i = 0; i < leaf->count; ++i)
+          leaf->at(i)->~value_type();
+        drop_leaf(leaf);
+        return;
+      }
+
+      inner_t *inner = static_cast<inner_t *>(node);
+      for (std::size_t i = 0; i < inner->count; ++i)
+        drop_tree(inner->children[i], height - 1);
+      drop_inner(inner);
+    }
+};
+
+#endif /* BLOCKMAP_HPP_ */
@@ -11,198 +11,450 @@
 #ifndef CHUNKLIST_HPP_
 #define CHUNKLIST_HPP_
 
-#include <iostream>
+#include "allocstats.hpp"
+#include "backingpolicy.hpp"
+#include "growthpolicy.hpp"
+
+#include <algorithm>
 #include <cstddef>
-#include <cstring>
+#include <cstdlib>
+#include <functional>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+
+/** Size of the cache line, the alignment of the padded cells. */
+const std::size_t CACHE_LINE_SIZE = 64;
+
+/** The capacity of the pool is set on the construction, not by the type. */
+const std::size_t runtime_capacity = 0;
+
+/** Capacity of the runtime pool constructed by default without the value in
+    the environment. */
+const std::size_t RUNTIME_CAPACITY_DEFAULT = 1024;
+
+
+/**
+ * @brief Check the capacity of the pool.
+ * @param capacity [in] - number of the cells.
+ * @return the capacity, std::invalid_argument is thrown if it is 0.
+ */
+inline std::size_t checked_capacity(std::size_t capacity)
+{
+  if (capacity == 0)
+    throw std::invalid_argument("The capacity of the pool must be positive");
+  return capacity;
+}
+
+
+/**
+ * @brief Capacity of the pool from the environment variable.
+ *
+ * The value must be the positive decimal number, otherwise (0, the sign, the
+ * garbage) the fallback is used.
+ * @param name [in] - name of the variable.
+ * @param fallback [in] - the capacity if the variable is not set or invalid,
+ *                        std::invalid_argument is thrown if it is 0.
+ * @return the positive capacity.
+ */
+inline std::size_t capacity_from_env(const char *name, std::size_t fallback)
+{
+  checked_capacity(fallback);
+  const char *env = std::getenv(name);
+  if (env == nullptr || *env < '0' || *env > '9')
+    return fallback;
+
+  char *end = nullptr;
+  unsigned long long val = std::strtoull(env, &end, 10);
+  return *end == '\0' && val > 0 ? static_cast<std::size_t>(val) : fallback;
+}
+
+
+/**
+ * @brief Capacity of the runtime pools constructed by default.
+ *
+ * The ALLOCATOR_CAPACITY environment variable is read once, without it the
+ * capacity is RUNTIME_CAPACITY_DEFAULT.
+ * @return the capacity.
+ */
+inline std::size_t default_runtime_capacity()
+{
+  static const std::size_t capacity =
+      capacity_from_env("ALLOCATOR_CAPACITY", RUNTIME_CAPACITY_DEFAULT);
+  return capacity;
+}
 
 
 /* Forward ad */
-template<typename T, std::size_t CAPACITY>
+template<typename T, std::size_t CAPACITY, typename GROWTH = no_growth,
+         typename BACKING = heap_backing, std::size_t SLOT_ALIGN = 0>
 class chunk_list;
 
 
-namespace {
-
 /**
- * Discription item memory as a doubly linked list.
+ * Discription item memory as a singly linked list of free cells.
  *
+ * The link to the next free cell is stored in the place of the data, so the
+ * occupied cell has no overhead: its size is the size of the data, but not
+ * less than the size of the pointer.
+ *
+ * The cell is aligned as T or on ALIGN if it is larger, the size of the cell
+ * is the multiple of its alignment: with ALIGN = CACHE_LINE_SIZE the objects
+ * never share the cache line.
  * @tparam T - the type of the data in the cells.
+ * @tparam ALIGN - the minimal alignment of the cell, 0 - natural alignment.
  */
-template<typename T>
-struct chunk
+template<typename T, std::size_t ALIGN = 0>
+union chunk
 {
-  chunk *next;  /**< - pointer to the next item in the list. */
-  chunk *prev;  /**< - pointer to the previous item in the list. */
+  static_assert((ALIGN & (ALIGN - 1)) == 0,
+                "The alignment must be the power of 2");
+
+  chunk *next;  /**< - pointer to the next free item in the list. */
 
-  T value;      /**< - cells with information */
+  alignas(T) alignas(ALIGN == 0 ? alignof(T) : ALIGN)
+  unsigned char value[sizeof(T)];  /**< - cells with information */
 };
 
 
 /**
- * Swap the node list.
+ * Discription of the additional block of cells allocated on growth.
  *
- * @tparam Tp - the type of variable stored in the node.
- * @tparam Aloc - allocator, memory manager for working with container. Default
- *                on std::allocator.
- * @param dst [in] - receiving container.
- * @param src [out] - source container.
+ * @tparam T - the type of the data in the cells.
+ * @tparam ALIGN - the minimal alignment of the cells.
  */
-template<typename Tp, std::size_t SZ>
-void swap(chunk_list<Tp, SZ> &dst, chunk_list<Tp, SZ> &src)
+template<typename T, std::size_t ALIGN = 0>
+struct chunk_block
 {
-  std::swap(dst.size_, src.size_);
-  std::swap(dst.ptr_list_, src.ptr_list_);
-  std::swap(dst.head_, src.head_);
-}
+  chunk_block *next;    /**< - pointer to the previous allocated block. */
+  chunk<T, ALIGN> *items; /**< - cells of the block. */
+  std::size_t capacity; /**< - number of cells in the block. */
+};
 
 
 /**
- * Copying the nodes.
+ * Swap the chunk list.
  *
- * @tparam Tp - the type of variable stored in the node.
- * @tparam Aloc - allocator, memory manager for working with container. Default
- *                on std::allocator.
- * @param dst [in] - reference to the source node list.
- * @param src [out] - reference to the source node list.
+ * @tparam Tp - the type of the data in the cells.
+ * @tparam SZ - number of memory cells of a given type.
+ * @tparam Gr - growth policy.
+ * @tparam Bk - backing policy.
+ * @tparam Al - alignment of the cells.
+ * @param dst [in] - receiving container.
+ * @param src [out] - source container.
  */
-template<typename Tp, std::size_t SZ>
-void copy(chunk_list<Tp, SZ> &dst, const chunk_list<Tp, SZ> &src)
+template<typename Tp, std::size_t SZ, typename Gr, typename Bk, std::size_t Al>
+void swap(chunk_list<Tp, SZ, Gr, Bk, Al> &dst,
+          chunk_list<Tp, SZ, Gr, Bk, Al> &src)
 {
-  dst.size_ = src.size_;
-  dst.head_ = nullptr;
-
-  if (dst.size() > 0) {
-    std::size_t count = 0;
-    std::size_t size = dst.size();
-    chunk<Tp> *cur_other = src.ptr_list_;
-    while (count < size) {
-      Tp * tmp_ptr = src.alloc();
-      std::memcpy(tmp_ptr, &cur_other->value, sizeof(Tp));
-      dst.head_ = cur_other;
-      cur_other = cur_other->next;
-      ++count;
-    }
-  }
+  std::swap(dst.size_, src.size_);
+  std::swap(dst.first_block_, src.first_block_);
+  std::swap(dst.capacity_, src.capacity_);
+  std::swap(dst.last_block_, src.last_block_);
+  std::swap(dst.ptr_list_, src.ptr_list_);
+  std::swap(dst.blocks_, src.blocks_);
+  std::swap(dst.index_, src.index_);
+  std::swap(dst.free_, src.free_);
+  std::swap(dst.fresh_, src.fresh_);
+  std::swap(dst.fresh_end_, src.fresh_end_);
+  std::swap(dst.stats_, src.stats_);
 }
 
-} /* namespace */
-
 
 /**
  * Discription structure to the allocated memory.
  *
- * This is the buffer that represents the simple doubly linked list.
+ * This is the buffer that represents the simple singly linked list of free
+ * cells. Any cell can be returned to the list in any order, so the allocation
+ * and the deallocation are O(1).
+ *
+ * The cells are initialized lazily: the never used cells of the last block
+ * are handed out by the bump pointer, only the returned cells are linked into
+ * the free list. So the construction is O(1) and the pages of the buffer are
+ * touched only when they are used.
+ *
+ * When all the cells are occupied, the list asks the growth policy for the
+ * size of the next block and chains it, the already allocated cells never
+ * move. With the "no_growth" policy the size of the buffer is fixed.
+ *
+ * The blocks are taken from the backing policy: the system heap or the mapped
+ * (huge, prefaulted) pages, see backingpolicy.hpp.
+ *
+ * The owner of the address is checked once per release: the first block in
+ * O(1), the additional ones by the binary search in the index sorted by the
+ * address, O(log B) for B blocks.
+ *
+ * The size of the first block is CAPACITY or the argument of the constructor,
+ * so one instantiation with CAPACITY = runtime_capacity serves the pools of
+ * any size; by default it takes default_runtime_capacity().
+ *
+ * With ALLOCATOR_STATS defined the list counts its operations, see stats().
  * @tparam T - the type of the data in the cells.
- * @tparam CAPACITY - number of memory cells of a given type.
+ * @tparam CAPACITY - number of memory cells of a given type in the first
+ *                    block, runtime_capacity to set it on the construction.
+ * @tparam GROWTH - growth policy. Default on no_growth.
+ * @tparam BACKING - backing policy of the blocks. Default on heap_backing.
+ * @tparam SLOT_ALIGN - the minimal alignment of the cells, for example
+ *                      CACHE_LINE_SIZE to avoid the false sharing. Default on
+ *                      0 - the alignment of T.
  */
-template<typename T, std::size_t CAPACITY>
+template<typename T, std::size_t CAPACITY, typename GROWTH, typename BACKING,
+         std::size_t SLOT_ALIGN>
 class chunk_list
 {
   public:
     /**
-     * Constructor
+     * Constructor, the cells are not touched.
      */
-    chunk_list() {
-      for (std::size_t i = 0; i < CAPACITY; ++i) {
-        if (i == 0)
-          ptr_list_[i].prev = nullptr;
-        else
-          ptr_list_[i]. prev = &ptr_list_[i - 1];
+    chunk_list() = default;
 
-        if (i == CAPACITY - 1)
-          ptr_list_[i].next = nullptr;
-        else
-          ptr_list_[i].next = &ptr_list_[i + 1];
-      }
-    }
+    /**
+     * @brief Constructor with the size of the first block, the cells are not
+     *        touched.
+     * @param capacity [in] - number of the cells in the first block,
+     *                        std::invalid_argument is thrown if it is 0.
+     */
+    explicit chunk_list(std::size_t capacity)
+      : first_block_(checked_capacity(capacity))
+    {}
 
     /**
      * Virtual distructor
      */
     virtual ~chunk_list() {
-      ::operator delete[](ptr_list_);
+      while (blocks_) {
+        block_t *next = blocks_->next;
+        BACKING::release(blocks_->items, blocks_->capacity * sizeof(cell_t),
+                         alignof(cell_t));
+        delete blocks_;
+        blocks_ = next;
+      }
+      BACKING::release(ptr_list_, first_block_ * sizeof(cell_t),
+                       alignof(cell_t));
     }
 
     /**
      * @brief Move constructor.
+     *
+     * The source is left without the blocks, its first block is allocated on
+     * the next request.
      * @param other [in] - the object to move.
      */
-    chunk_list(chunk_list &&other) {
-      swap(this, other);
+    chunk_list(chunk_list &&other) noexcept
+      : size_(other.size_), first_block_(other.first_block_),
+        capacity_(other.capacity_), last_block_(other.last_block_),
+        ptr_list_(other.ptr_list_), blocks_(other.blocks_),
+        index_(std::move(other.index_)), free_(other.free_),
+        fresh_(other.fresh_), fresh_end_(other.fresh_end_),
+        stats_(other.stats_) {
+      other.size_ = 0;
+      other.capacity_ = 0;
+      other.last_block_ = other.first_block_;
+      other.ptr_list_ = nullptr;
+      other.blocks_ = nullptr;
+      other.index_.clear();
+      other.free_ = nullptr;
+      other.fresh_ = nullptr;
+      other.fresh_end_ = nullptr;
+      other.stats_ = pool_stats();
     }
 
     /**
      * @brief Move operator.
      * @param other [in] - the object to move.
      */
-    chunk_list & operator=(chunk_list &&other) {
-      swap(this, other);
+    chunk_list & operator=(chunk_list &&other) noexcept {
+      swap(*this, other);
       return *this;
     }
 
     /**
      * @brief Copy constructor.
-     * @param other [in] - the object to copy.
+     *
+     * The occupied cells belong to the owner of the source buffer, so the copy
+     * starts with its own empty buffer of the same first block.
      */
-    chunk_list(const chunk_list &other) {
-      copy(this, other);
-    }
+    chunk_list(const chunk_list &other)
+      : chunk_list(other.first_block_)
+    {}
 
     /**
      * @brief Copy operator.
-     * @param other [in] - the object to copy.
+     *
+     * Keeps its own buffer, see the copy constructor.
      */
-    chunk_list & operator=(const chunk_list &other) {
-      copy(this, other);
+    chunk_list & operator=(const chunk_list &) {
       return *this;
     }
 
     /**
      * @brief Allocate memory for an object.
-     * @return Pointer on the memory for an object.
+     * @return Pointer on the memory for an object or nullptr if memory is
+     *         filled and the growth policy does not allow to add a block.
      */
     T * alloc() {
-      if (head_ == nullptr && ptr_list_ != nullptr)
-        head_ = ptr_list_;
-      else if (head_->next != nullptr)
-        head_ = head_->next;
-      else
-        return nullptr;
-
-      ++size_;
-      return &head_->value;
+      return stats_.timed([this] { return pop(); });
     }
 
     /**
      * @brief Deallocate memory from the object.
      * @param ptr [in] - pointer to the object.
+     * @return true if the memory belongs to the list and is released,
+     *         otherwise false.
+     */
+    bool dealloc(T *ptr) {
+      if (ptr == nullptr || !is_valid_addr(ptr))
+        return false;
+
+      cell_t *item = to_chunk(ptr);
+      item->next = free_;
+      free_ = item;
+      --size_;
+      stats_.on_free();
+      return true;
+    }
+
+    /**
+     * @brief Allocate memory for several objects, each in its own cell.
+     *
+     * The never used cells are taken by the bump pointer at once, so the
+     * cost of the call is amortised over the cells.
+     * @param out [out] - pointers to the memory of the objects.
+     * @param n [in] - number of objects.
+     * @return number of the allocated cells, less than n if memory is filled
+     *         and the growth policy does not allow to add a block.
      */
-    void dealloc(T *ptr) {
-      if (!is_valid_addr(ptr) && ptr == nullptr)
-        return;
+    std::size_t alloc_bulk(T **out, std::size_t n) {
+      std::size_t done = 0;
 
-      if (ptr == &head_->value) {
-        head_ = head_->prev;
-        --size_;
+      while (done < n && free_ != nullptr) {
+        out[done++] = reinterpret_cast<T *>(free_->value);
+        free_ = free_->next;
       }
+
+      size_ += done;
+      if (done > 0)
+        stats_.on_alloc(size_, done);
+      return done + alloc_fresh(out + done, n - done);
+    }
+
+    /**
+     * @brief Allocate memory for several objects only in the never used
+     *        cells, the free list is not touched.
+     *
+     * The cells of one block follow each other in the address order, so the
+     * objects are placed in the contiguous runs.
+     * @param out [out] - pointers to the memory of the objects.
+     * @param n [in] - number of objects.
+     * @return number of the allocated cells, less than n if memory is filled
+     *         and the growth policy does not allow to add a block.
+     */
+    std::size_t alloc_fresh(T **out, std::size_t n) {
+      std::size_t done = 0;
+
+      while (done < n) {
+        if (fresh_ == fresh_end_ && !refill())
+          break;
+
+        std::size_t take = static_cast<std::size_t>(fresh_end_ - fresh_);
+        if (take > n - done)
+          take = n - done;
+        for (std::size_t i = 0; i < take; ++i)
+          out[done++] = reinterpret_cast<T *>(fresh_[i].value);
+        fresh_ += take;
+      }
+
+      size_ += done;
+      if (done > 0)
+        stats_.on_alloc(size_, done);
+      return done;
+    }
+
+    /**
+     * @brief Deallocate memory of several objects.
+     *
+     * The cells are linked into the chain and the chain is added to the free
+     * list at once.
+     * @param ptrs [in] - pointers to the objects.
+     * @param n [in] - number of objects.
+     */
+    void dealloc_bulk(T * const *ptrs, std::size_t n) {
+      cell_t *head = free_;
+      std::size_t count = 0;
+
+      for (std::size_t i = 0; i < n; ++i) {
+        if (ptrs[i] == nullptr || !is_valid_addr(ptrs[i]))
+          continue;
+
+        cell_t *item = to_chunk(ptrs[i]);
+        item->next = head;
+        head = item;
+        ++count;
+      }
+
+      free_ = head;
+      size_ -= count;
+      stats_.on_free(count);
     }
 
     /**
      * @brief Check on valid addres.
+     *
+     * O(1) for the first block, O(log B) for B additional blocks.
      * @param ptr [] - pointer to the checked address.
      * @return true is addres valid otherwise false.
      */
-    bool is_valid_addr(T *ptr) {
-      return (char *)ptr >= (char *)ptr_list_ &&
-             (char *)ptr < (char *)(ptr_list_ + (CAPACITY * sizeof(chunk<T>)));
+    bool is_valid_addr(T *ptr) const {
+      if (ptr_list_ != nullptr && in_block(ptr, ptr_list_, first_block_))
+        return true;
+      if (index_.empty())
+        return false;
+
+      auto blk = std::upper_bound(index_.begin(), index_.end(), ptr,
+                                  [](T *p, const block_t *b) {
+                                    return std::less<const void *>()(
+                                        p, b->items);
+                                  });
+      if (blk == index_.begin())
+        return false;
+      --blk;
+      return in_block(ptr, (*blk)->items, (*blk)->capacity);
     }
 
     /**
      * @brief Memory status, full or not.
+     *
+     * The filled list still can allocate if the growth policy allows it.
      * @return true is filled, otherwise false.
      */
     bool is_filled() {
-      return size() == CAPACITY;
+      return size() == capacity();
+    }
+
+    /**
+     * @brief Capacity.
+     * @return Number of cells in all the allocated blocks.
+     */
+    std::size_t capacity() {
+      return capacity_;
+    }
+
+    /**
+     * @brief Capacity on the construction.
+     * @return Number of cells in the first block.
+     */
+    std::size_t initial_capacity() const {
+      return first_block_;
+    }
+
+    /**
+     * @brief The first block.
+     * @return pointer to the cells of the first block, owned only by this
+     *         list.
+     */
+    const void * data() const {
+      return ptr_list_;
     }
 
     /**
@@ -213,19 +465,141 @@ class chunk_list
       return size_;
     }
 
+    /**
+     * @brief Statistics of the list.
+     *
+     * Without ALLOCATOR_STATS only the size and the capacity are filled.
+     * @return the snapshot of the statistics.
+     */
+    pool_stats_snapshot stats() const {
+      return stats_.snapshot(size_, capacity_);
+    }
+
 
   private:
+    using cell_t = chunk<T, SLOT_ALIGN>;
+    using block_t = chunk_block<T, SLOT_ALIGN>;
+
     std::size_t size_ = 0;    /**< - the number of occupied items */
-    chunk<T> *ptr_list_ =     /**< - pointer */
-        static_cast<chunk<T> *>(::operator new[](CAPACITY * sizeof(chunk<T>)));
-    chunk<T> *head_ = nullptr;  /**< - pointer on the head list. */
+    std::size_t first_block_ = CAPACITY != runtime_capacity
+        ? CAPACITY : default_runtime_capacity(); /**< - size of the first
+                                                       block */
+    std::size_t capacity_ = first_block_;   /**< - the number of all items */
+    std::size_t last_block_ = first_block_; /**< - size of the last block */
+    cell_t *ptr_list_ =     /**< - pointer */
+        static_cast<cell_t *>(BACKING::alloc(first_block_ * sizeof(cell_t),
+                                             alignof(cell_t)));
+    block_t *blocks_ = nullptr;  /**< - additional blocks. */
+    std::vector<block_t *> index_; /**< - additional blocks sorted by the
+                                          address of the cells. */
+    cell_t *free_ = nullptr;  /**< - pointer on the head of the free list. */
+    cell_t *fresh_ = ptr_list_; /**< - first never used cell. */
+    cell_t *fresh_end_ = ptr_list_ + first_block_;  /**< - end of the fresh
+                                                          cells */
+    pool_stats stats_;          /**< - counters of the operations. */
 
-    /* Friends function */
-    template<typename Tp, std::size_t SZ>
-    friend void swap(chunk_list<Tp, SZ> &dst, chunk_list<Tp, SZ> &src);
+    /**
+     * @brief Take the cell from the head of the free list or the never used
+     *        one.
+     * @return pointer on the cell or nullptr if the list can not grow.
+     */
+    T * pop() {
+      cell_t *item = free_;
+      if (item != nullptr)
+        free_ = item->next;
+      else {
+        if (fresh_ == fresh_end_ && !refill())
+          return nullptr;
+        item = fresh_++;
+      }
+
+      ++size_;
+      stats_.on_alloc(size_);
+      return reinterpret_cast<T *>(item->value);
+    }
 
-    template<typename Tp, std::size_t SZ>
-    friend void copy(chunk_list<Tp, SZ> &dst, const chunk_list<Tp, SZ> &src);
+    /**
+     * @brief Make the never used cells: the first block of the moved list or
+     *        the next block according to the growth policy.
+     * @return true if the cells are added, otherwise false.
+     */
+    bool refill() {
+      if (ptr_list_ == nullptr) {
+        ptr_list_ = static_cast<cell_t *>(
+                      BACKING::alloc(first_block_ * sizeof(cell_t),
+                                     alignof(cell_t)));
+        capacity_ += first_block_;
+        fresh_ = ptr_list_;
+        fresh_end_ = ptr_list_ + first_block_;
+        return true;
+      }
+
+      stats_.on_fill();
+      return grow();
+    }
+
+    /**
+     * @brief Allocate the next block according to the growth policy.
+     * @return true if the block is added, otherwise false.
+     */
+    bool grow() {
+      std::size_t count = GROWTH::next_block(last_block_);
+      if (count == 0)
+        return false;
+
+      cell_t *items =
+          static_cast<cell_t *>(BACKING::alloc(count * sizeof(cell_t),
+                                               alignof(cell_t)));
+      block_t *blk = nullptr;
+      try {
+        blk = new block_t{blocks_, items, count};
+        index_.insert(std::upper_bound(index_.begin(), index_.end(), blk,
+                                       [](const block_t *a, const block_t *b) {
+                                         return std::less<const void *>()(
+                                             a->items, b->items);
+                                       }),
+                      blk);
+      }
+      catch (...) {
+        delete blk;
+        BACKING::release(items, count * sizeof(cell_t), alignof(cell_t));
+        throw;
+      }
+      blocks_ = blk;
+      capacity_ += count;
+      last_block_ = count;
+      fresh_ = items;
+      fresh_end_ = items + count;
+      stats_.on_grow();
+      return true;
+    }
+
+    /**
+     * @brief Check that the address belongs to the block.
+     * @param ptr [in] - pointer to the checked address.
+     * @param items [in] - pointer to the first cell of the block.
+     * @param count [in] - number of cells in the block.
+     * @return true if the address belongs to the block, otherwise false.
+     */
+    static bool in_block(T *ptr, const cell_t *items, std::size_t count) {
+      std::less<const void *> less;
+      return !less(ptr, items) && less(ptr, items + count);
+    }
+
+    /**
+     * @brief Cell which contains the object.
+     * @param ptr [in] - pointer to the object inside the buffer.
+     * @return pointer to the cell.
+     */
+    static cell_t * to_chunk(T *ptr) {
+      return reinterpret_cast<cell_t *>(ptr);
+    }
+
+    /* Friends function */
+    template<typename Tp, std::size_t SZ, typename Gr, typename Bk,
+             std::size_t Al>
+    friend void swap(chunk_list<Tp, SZ, Gr, Bk, Al> &dst,
+                     chunk_list<Tp, SZ, Gr, Bk, Al> &src);
 };
 
 
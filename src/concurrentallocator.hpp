@@ -0,0 +1,398 @@
+/**
+ ******************************************************************************
+ * @file    concurrentallocator.hpp
+ * @author  Maxim <aveter@bk.ru>
+ * @date    18/05/2019
+ * @brief   Description of the template "Concurrent Allocator".
+ ******************************************************************************
+ */
+
+#ifndef CONCURRENTALLOCATOR_HPP_
+#define CONCURRENTALLOCATOR_HPP_
+
+#include "backingpolicy.hpp"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <utility>
+
+
+/**
+ * Discription item memory of the concurrent pool.
+ *
+ * The free cell keeps the link to the next cell of its batch, the link is
+ * written and read only by the thread which owns the batch.
+ * @tparam T - the type of the data in the cells.
+ */
+template<typename T>
+union concurrent_chunk
+{
+  concurrent_chunk *next;   /**< - next cell of the batch. */
+
+  alignas(T) unsigned char value[sizeof(T)];  /**< - cells with information */
+};
+
+
+/**
+ * Discription of the batch in the depot of the concurrent pool.
+ *
+ * The descriptor of the batch is kept apart from the cells under the index of
+ * its first cell: the thread which pops the batch reads the link before it
+ * owns the batch, and the cells at that time may be already handed out to the
+ * user.
+ */
+struct concurrent_batch
+{
+  std::atomic<std::uint32_t> next{0};   /**< - next batch in the depot. */
+};
+
+
+/**
+ * Discription of the pool shared between the threads.
+ *
+ * The cells are handed out to the threads in batches of MAGAZINE cells.
+ * Every thread keeps its own magazine of the free cells and works with it
+ * without any synchronization. When the magazine is empty it is refilled with
+ * one batch from the depot (or with the never used cells), when it is
+ * overfilled one batch goes back to the depot. The depot is a lock-free stack
+ * of batches with the tagged head, so the same batch can not be taken twice.
+ *
+ * The cell may be freed in any thread, not only in the one that allocated it.
+ * The cells cached in the magazines of the other threads are not available,
+ * so the pool may report the exhaustion a bit earlier than CAPACITY.
+ *
+ * The pool is never destroyed: the magazines of the threads return their
+ * cells on the thread exit, which may happen after the static objects are
+ * destroyed.
+ * @tparam T - the type of the data in the cells.
+ * @tparam CAPACITY - number of memory cells of a given type.
+ * @tparam MAGAZINE - number of cells in the batch.
+ */
+template<typename T, std::size_t CAPACITY, std::size_t MAGAZINE = 32>
+class concurrent_pool
+{
+  static_assert(CAPACITY > 0 && CAPACITY < UINT32_MAX,
+                "The capacity must be in the range of the cell index");
+  static_assert(MAGAZINE > 0, "The magazine must not be empty");
+
+  public:
+    /**
+     * Virtual distructor
+     */
+    virtual ~concurrent_pool() {
+      heap_backing::release(ptr_list_, CAPACITY * sizeof(chunk_t),
+                            alignof(chunk_t));
+      delete[] batches_;
+    }
+
+    concurrent_pool(const concurrent_pool &) = delete;
+    concurrent_pool & operator=(const concurrent_pool &) = delete;
+
+    /**
+     * @brief The pool of the type, shared by all the threads, created on the
+     *        first call and never destroyed.
+     * @return reference to the pool.
+     */
+    static concurrent_pool & instance() {
+      static concurrent_pool *pool = new concurrent_pool();
+      return *pool;
+    }
+
+    /**
+     * @brief Allocate memory for an object from the magazine of the thread.
+     * @return Pointer on the memory for an object or nullptr if memory is
+     *         filled.
+     */
+    T * alloc() {
+      magazine &mag = local();
+      if (mag.count == 0 && !refill(mag))
+        return nullptr;
+
+      return reinterpret_cast<T *>(mag.items[--mag.count]);
+    }
+
+    /**
+     * @brief Deallocate memory to the magazine of the thread.
+     * @param ptr [in] - pointer to the object.
+     */
+    void dealloc(T *ptr) {
+      if (ptr == nullptr)
+        return;
+
+      magazine &mag = local();
+      if (mag.count == 2 * MAGAZINE)
+        flush(mag, MAGAZINE);
+
+      mag.items[mag.count++] = reinterpret_cast<chunk_t *>(ptr);
+    }
+
+    /**
+     * @brief Check on valid addres.
+     * @param ptr [] - pointer to the checked address.
+     * @return true is addres valid otherwise false.
+     */
+    bool is_valid_addr(T *ptr) {
+      return (char *)ptr >= (char *)ptr_list_ &&
+             (char *)ptr < (char *)(ptr_list_ + CAPACITY);
+    }
+
+
+  private:
+    using chunk_t = concurrent_chunk<T>;
+
+    /**
+     * Constructor, the pool is created only by instance().
+     */
+    concurrent_pool() = default;
+
+    /**
+     * The free cells cached by the thread.
+     */
+    struct magazine
+    {
+      chunk_t *items[2 * MAGAZINE];   /**< - free cells. */
+      std::size_t count = 0;          /**< - number of the free cells. */
+      concurrent_pool *owner;         /**< - the pool of the cells. */
+
+      /**
+       * @brief Constructor.
+       * @param pool [in] - the pool of the cells.
+       */
+      explicit magazine(concurrent_pool *pool)
+        : owner(pool)
+      {}
+
+      /**
+       * Distructor, returns the cells to the depot on the thread exit.
+       */
+      ~magazine() {
+        while (count > 0)
+          owner->flush(*this, count < MAGAZINE ? count : MAGAZINE);
+      }
+    };
+
+    chunk_t *ptr_list_ =      /**< - pointer */
+        static_cast<chunk_t *>(heap_backing::alloc(CAPACITY * sizeof(chunk_t),
+                                                   alignof(chunk_t)));
+    concurrent_batch *batches_ =  /**< - descriptors of the batches by the
+                                           index of the first cell */
+        new concurrent_batch[CAPACITY];
+    std::atomic<std::size_t> fresh_{0};     /**< - first never used cell */
+    std::atomic<std::uint64_t> depot_{0};   /**< - tagged head of the depot */
+
+    /**
+     * @brief The magazine of the current thread.
+     * @return reference to the magazine.
+     */
+    magazine & local() {
+      static thread_local magazine mag(this);
+      return mag;
+    }
+
+    /**
+     * @brief Index of the cell in the depot, 0 is the empty depot.
+     * @param item [in] - pointer to the cell.
+     * @return index of the cell.
+     */
+    std::uint32_t to_index(chunk_t *item) {
+      return static_cast<std::uint32_t>(item - ptr_list_) + 1;
+    }
+
+    /**
+     * @brief Refill the empty magazine.
+     * @param mag [in] - the magazine of the thread.
+     * @return true if the magazine is refilled, otherwise false.
+     */
+    bool refill(magazine &mag) {
+      chunk_t *item = pop_batch();
+      if (item != nullptr) {
+        for (; item != nullptr; item = item->next)
+          mag.items[mag.count++] = item;
+        return true;
+      }
+
+      if (fresh_.load(std::memory_order_relaxed) >= CAPACITY)
+        return false;
+
+      std::size_t first = fresh_.fetch_add(MAGAZINE, std::memory_order_relaxed);
+      for (std::size_t i = first; i < first + MAGAZINE && i < CAPACITY; ++i)
+        mag.items[mag.count++] = &ptr_list_[i];
+
+      return mag.count > 0;
+    }
+
+    /**
+     * @brief Move the cells from the top of the magazine to the depot.
+     * @param mag [in] - the magazine of the thread.
+     * @param count [in] - number of cells in the batch.
+     */
+    void flush(magazine &mag, std::size_t count) {
+      chunk_t *head = nullptr;
+      for (std::size_t i = 0; i < count; ++i) {
+        chunk_t *item = mag.items[--mag.count];
+        item->next = head;
+        head = item;
+      }
+      push_batch(head);
+    }
+
+    /**
+     * @brief Push the batch to the depot.
+     * @param head [in] - the first cell of the batch.
+     */
+    void push_batch(chunk_t *head) {
+      std::uint64_t top = depot_.load(std::memory_order_relaxed);
+      std::uint64_t next;
+      std::uint32_t index = to_index(head);
+      do {
+        batches_[index - 1].next.store(static_cast<std::uint32_t>(top),
+                                       std::memory_order_relaxed);
+        next = ((top >> 32) + 1) << 32 | index;
+      } while (!depot_.compare_exchange_weak(top, next,
+                                             std::memory_order_release,
+                                             std::memory_order_relaxed));
+    }
+
+    /**
+     * @brief Pop the batch from the depot.
+     * @return the first cell of the batch or nullptr if the depot is empty.
+     */
+    chunk_t * pop_batch() {
+      std::uint64_t top = depot_.load(std::memory_order_acquire);
+      while (static_cast<std::uint32_t>(top) != 0) {
+        std::uint32_t index = static_cast<std::uint32_t>(top) - 1;
+        std::uint64_t next = ((top >> 32) + 1) << 32 |
+                             batches_[index].next.load(
+                                 std::memory_order_relaxed);
+        if (depot_.compare_exchange_weak(top, next,
+                                         std::memory_order_acquire,
+                                         std::memory_order_acquire))
+          return &ptr_list_[index];
+      }
+      return nullptr;
+    }
+};
+
+
+/**
+ * Discription of the "Concurrent Allocator" class.
+ *
+ * All the allocators of the same type share one "Concurrent Pool", so the
+ * memory allocated by one thread (or one container) may be freed by another.
+ * The requests for several objects go to the system heap.
+ * @tparam T - data types.
+ * @tparam ELEMENTS - the size of memory to reserv.
+ */
+template<typename T, std::size_t ELEMENTS>
+class concurrent_allocator
+{
+  public:
+    /* Aliases */
+    using value_type = T;
+    using pointer = T *;
+    using const_pointer = const T *;
+    using reference = T &;
+    using const_reference = const T &;
+    using is_always_equal = std::true_type;
+
+
+    template<typename U>
+    struct rebind {
+      using other = concurrent_allocator<U, ELEMENTS>;
+    };
+
+    /* By default ... */
+    concurrent_allocator() = default;
+    ~concurrent_allocator() = default;
+
+    concurrent_allocator(const concurrent_allocator &) = default;
+    concurrent_allocator &operator=(const concurrent_allocator &) = default;
+
+    /**
+     * @brief Converting constructor, the allocators have no state.
+     */
+    template<typename U>
+    concurrent_allocator(const concurrent_allocator<U, ELEMENTS> &)
+    {}
+
+    /**
+     * @brief allocation of a given "piece" of memory.
+     * @param n [in] - amount of memory requested.
+     * @return pointer to the allocated memory.
+     */
+    pointer allocate(std::size_t n) {
+      if (n != 1)
+        return static_cast<pointer>(heap_backing::alloc(n * sizeof(T),
+                                                        alignof(T)));
+
+      pointer res = pool_t::instance().alloc();
+      if (res == nullptr)
+        throw std::bad_alloc();
+      return res;
+    }
+
+    /**
+     * @brief Release a specified amount of memory.
+     * @param p [in] - pointer to the beginning of the memory.
+     * @param n [in] - size of free memory.
+     */
+    void deallocate(pointer p, std::size_t n) {
+      if (n != 1)
+        heap_backing::release(p, n * sizeof(T), alignof(T));
+      else
+        pool_t::instance().dealloc(p);
+    }
+
+    /**
+     * @brief Object construction.
+     * @tparam U - type of object constructed.
+     * @tparam Args - constructor parameters.
+     * @param p [in] - pointer of the object.
+     * @param args [in] - input parameters of the constructor.
+     */
+    template<class U, class... Args>
+    void construct(U *p, Args &&... args) {
+      ::new((void *) p) U(std::forward<Args>(args)...);
+    }
+
+    /**
+     * @brief Object distruction.
+     * @tparam U - type of object distroy.
+     * @param p [in] - pointer of the object.
+     */
+    template<class U>
+    void destroy(U *p) {
+      p->~U();
+    }
+
+
+  private:
+    using pool_t = concurrent_pool<T, ELEMENTS>;
+};
+
+
+/**
+ * @brief Comparison operator, the allocators share the pool of the type.
+ * @return always true.
+ */
+template<typename T, typename U, std::size_t ELEMENTS>
+bool operator==(const concurrent_allocator<T, ELEMENTS> &,
+                const concurrent_allocator<U, ELEMENTS> &)
+{
+  return true;
+}
+
+/**
+ * @brief Inequality operator, the allocators share the pool of the type.
+ * @return always false.
+ */
+template<typename T, typename U, std::size_t ELEMENTS>
+bool operator!=(const concurrent_allocator<T, ELEMENTS> &,
+                const concurrent_allocator<U, ELEMENTS> &)
+{
+  return false;
+}
+
+#endif  /* CONCURRENTALLOCATOR_HPP_ */
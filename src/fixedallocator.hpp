@@ -10,19 +10,48 @@
 #ifndef FIXEDALLOCATOR_HPP_
 #define FIXEDALLOCATOR_HPP_
 
+#include "alloctrace.hpp"
 #include "chunklist.hpp"
+#include "sizeclasspool.hpp"
 
 #include <cstddef>
+#include <memory>
+#include <new>
+#include <stdexcept>
 
 /**
  * Discription of the "Fixed Allocator" class.
  *
  * This class will allow you to pre-allocate memory for data in such containers
  * that do not have to do this using standart methods.
+ *
+ * When the reserved memory is filled, the allocator adds the blocks according
+ * to the growth policy. If the policy does not allow it, std::bad_alloc is
+ * thrown.
+ *
+ * The requests for several objects (up to MAX_POOLED_RUN) are served by the
+ * segregated size classes, only the larger ones (or when the size class is
+ * filled) go to the system heap.
+ *
+ * Build with ALLOCATOR_STATS to collect the statistics, see stats(), and with
+ * ALLOCATOR_TRACE to record the requests to the trace file for the replay.
+ * With ELEMENTS = runtime_capacity the size of the reserved memory is the
+ * argument of the constructor (for example, capacity_from_env()) or the
+ * ALLOCATOR_CAPACITY environment variable, so the pools are sized per host
+ * without the rebuild and one instantiation serves all the sizes.
  * @tparam T - data types.
- * @tparam ELEMENTS - the size of memory to reserv.
+ * @tparam ELEMENTS - the size of memory to reserv, runtime_capacity to set it
+ *                    on the construction.
+ * @tparam GROWTH - growth policy of the reserved memory. Default on no_growth.
+ * @tparam BACKING - backing policy of the reserved memory of single objects,
+ *                   for example mmap_backing<> for the huge pages. Default on
+ *                   heap_backing.
+ * @tparam SLOT_ALIGN - the minimal alignment of the cells of single objects,
+ *                      CACHE_LINE_SIZE keeps the objects on the separate cache
+ *                      lines. Default on 0 - the alignment of T.
  */
-template<typename T, std::size_t ELEMENTS>
+template<typename T, std::size_t ELEMENTS, typename GROWTH = no_growth,
+         typename BACKING = heap_backing, std::size_t SLOT_ALIGN = 0>
 class fixed_allocator
 {
   public:
@@ -34,21 +63,62 @@ class fixed_allocator
     using const_reference = const T &;
 
 
+    /** The largest number of objects served by the size classes. */
+    static constexpr std::size_t MAX_POOLED_RUN = 16;
+
     template<typename U>
     struct rebind {
-      using other = fixed_allocator<U, ELEMENTS>;
+      using other = fixed_allocator<U, ELEMENTS, GROWTH, BACKING, SLOT_ALIGN>;
     };
 
     /* By default ... */
     fixed_allocator() = default;
     ~fixed_allocator() = default;
 
-    fixed_allocator(const fixed_allocator &) = default;
     fixed_allocator(fixed_allocator &&) = default;
-
-    fixed_allocator &operator=(const fixed_allocator &) = default;
     fixed_allocator &operator=(fixed_allocator &&) = default;
 
+    /**
+     * @brief Constructor with the size of the reserved memory.
+     * @param elements [in] - number of the objects to reserve,
+     *                        std::invalid_argument is thrown if it is 0.
+     */
+    explicit fixed_allocator(std::size_t elements)
+      : mem_chunk_(elements)
+    {}
+
+    /**
+     * @brief Copy constructor.
+     *
+     * The memory belongs to the source allocator, so the copy starts with its
+     * own empty buffers of the same size.
+     */
+    fixed_allocator(const fixed_allocator &other)
+      : fixed_allocator(other.initial_capacity())
+    {}
+
+    /**
+     * @brief Constructor of the allocator of the other type, used by the
+     *        containers to rebind it.
+     *
+     * Starts with its own empty buffers of the same size.
+     * @param other [in] - the allocator of the other type.
+     */
+    template<typename U>
+    fixed_allocator(const fixed_allocator<U, ELEMENTS, GROWTH, BACKING,
+                                          SLOT_ALIGN> &other)
+      : fixed_allocator(other.initial_capacity())
+    {}
+
+    /**
+     * @brief Copy operator.
+     *
+     * Keeps its own buffers, see the copy constructor.
+     */
+    fixed_allocator &operator=(const fixed_allocator &) {
+      return *this;
+    }
+
     /**
      * @brief allocation of a given "piece" of memory.
      * @param n [in] - amount of memory requested.
@@ -58,31 +128,158 @@ class fixed_allocator
       pointer res = nullptr;
 
       if (n == 1) {
-        if (!mem_chunk_.is_filled()) {
-          res = mem_chunk_.alloc();
+        res = mem_chunk_.alloc();
+        if (res == nullptr)
+          throw std::bad_alloc();
+        trace_.on_alloc(res, n, sizeof(T), trace_single);
+      }
+      else {
+        if (n <= MAX_POOLED_RUN) {
+          if (!runs_)
+            runs_.reset(new runs_t(mem_chunk_.initial_capacity()));
+          res = runs_->alloc(n);
+        }
+
+        if (res == nullptr) {
+          res = static_cast<pointer>(heap_backing::alloc(n * sizeof(T),
+                                                         alignof(T)));
+          ++fallback_count_;
+          trace_.on_alloc(res, n, sizeof(T), trace_heap);
+        }
+        else {
+          ++pooled_run_count_;
+          trace_.on_alloc(res, n, sizeof(T), trace_runs);
         }
       }
-      else
-        res = reinterpret_cast<pointer>(::operator new(n * sizeof(T)));
 
       return res;
     }
 
     /**
      * @brief Release a specified amount of memory.
+     *
+     * std::invalid_argument is thrown if the single object does not belong to
+     * the allocator: it was allocated by the other one.
      * @param p [in] - pointer to the beginning of the memory.
      * @param n [in] - size of free memory.
      */
     void deallocate(pointer p, std::size_t n) {
       if (n == 1) {
-        if (mem_chunk_.is_valid_addr(p)) {
-          mem_chunk_.dealloc(p);
+        if (p == nullptr)
+          return;
+        if (!mem_chunk_.dealloc(p))
+          throw std::invalid_argument("The memory belongs to other allocator");
+        trace_.on_free(p, n, sizeof(T), trace_single);
+      }
+      else {
+        if (n <= MAX_POOLED_RUN && runs_ && runs_->dealloc(p, n)) {
+          trace_.on_free(p, n, sizeof(T), trace_runs);
           return;
         }
-        /* TODO: Added throw!!! */
+        trace_.on_free(p, n, sizeof(T), trace_heap);
+        heap_backing::release(p, n * sizeof(T), alignof(T));
+      }
+    }
+
+    /**
+     * @brief Allocation of the memory for several separate objects.
+     *
+     * All the objects are taken from the buffer in one call, std::bad_alloc is
+     * thrown if it can not give all of them.
+     * @param out [out] - pointers to the allocated memory.
+     * @param n [in] - number of objects.
+     */
+    void allocate_bulk(pointer *out, std::size_t n) {
+      std::size_t done = mem_chunk_.alloc_bulk(out, n);
+      if (done < n) {
+        mem_chunk_.dealloc_bulk(out, done);
+        throw std::bad_alloc();
       }
-      else
-        ::operator delete(p);
+      for (std::size_t i = 0; i < n; ++i)
+        trace_.on_alloc(out[i], 1, sizeof(T), trace_single);
+    }
+
+    /**
+     * @brief Allocation of the memory for several separate objects in the
+     *        never used cells, in the contiguous runs.
+     *
+     * The free cells are taken only if the never used ones are over and the
+     * growth policy does not allow to add a block. std::bad_alloc is thrown
+     * if the buffer can not give all of them.
+     * @param out [out] - pointers to the allocated memory.
+     * @param n [in] - number of objects.
+     */
+    void allocate_fresh(pointer *out, std::size_t n) {
+      std::size_t done = mem_chunk_.alloc_fresh(out, n);
+      if (done < n)
+        done += mem_chunk_.alloc_bulk(out + done, n - done);
+      if (done < n) {
+        mem_chunk_.dealloc_bulk(out, done);
+        throw std::bad_alloc();
+      }
+      for (std::size_t i = 0; i < n; ++i)
+        trace_.on_alloc(out[i], 1, sizeof(T), trace_single);
+    }
+
+    /**
+     * @brief Release the memory of several separate objects.
+     * @param ptrs [in] - pointers to the memory, allocated with allocate(1)
+     *                    or allocate_bulk().
+     * @param n [in] - number of objects.
+     */
+    void deallocate_bulk(pointer *ptrs, std::size_t n) {
+      for (std::size_t i = 0; i < n; ++i)
+        trace_.on_free(ptrs[i], 1, sizeof(T), trace_single);
+      mem_chunk_.dealloc_bulk(ptrs, n);
+    }
+
+    /**
+     * @brief Size of the reserved memory.
+     * @return number of the objects reserved on the construction.
+     */
+    std::size_t initial_capacity() const {
+      return mem_chunk_.initial_capacity();
+    }
+
+    /**
+     * @brief Identity of the reserved memory, the copies and the rebound
+     *        allocators have their own.
+     * @return pointer to the buffer of single objects.
+     */
+    const void * pool() const {
+      return mem_chunk_.data();
+    }
+
+    /**
+     * @brief Number of the requests for several objects that went to the
+     *        system heap.
+     * @return number of the requests.
+     */
+    std::size_t fallback_count() const {
+      return fallback_count_;
+    }
+
+    /**
+     * @brief Number of the requests for several objects served by the size
+     *        classes.
+     * @return number of the requests.
+     */
+    std::size_t pooled_run_count() const {
+      return pooled_run_count_;
+    }
+
+    /**
+     * @brief Statistics of the allocator.
+     *
+     * The counters of the buffer of single objects and the requests for
+     * several objects. Can be printed with operator<<.
+     * @return the snapshot of the statistics.
+     */
+    pool_stats_snapshot stats() const {
+      pool_stats_snapshot res = mem_chunk_.stats();
+      res.fallbacks = fallback_count_;
+      res.pooled_runs = pooled_run_count_;
+      return res;
     }
 
     /**
@@ -109,8 +306,48 @@ class fixed_allocator
 
 
    private:
-    chunk_list<T, ELEMENTS> mem_chunk_; /**< - structure to the allocated
-                                               memory - buffer. */
+    using runs_t = size_class_pool<T, ELEMENTS, GROWTH, 2, MAX_POOLED_RUN>;
+
+    chunk_list<T, ELEMENTS, GROWTH, BACKING, SLOT_ALIGN> mem_chunk_; /**< -
+                                          structure to the allocated memory -
+                                          buffer. */
+    std::unique_ptr<runs_t> runs_;        /**< - size classes, allocated on
+                                                 the first request. */
+    std::size_t fallback_count_ = 0;      /**< - requests to the heap */
+    std::size_t pooled_run_count_ = 0;    /**< - requests to the classes */
+    alloc_trace trace_;                   /**< - recording of the requests */
   };
 
+
+/**
+ * @brief Comparison operator.
+ *
+ * The memory of one allocator can be released only by itself, so the equal
+ * allocators are the same pool.
+ * @return true if the allocators share the pool.
+ */
+template<typename T, typename U, std::size_t ELEMENTS, typename GROWTH,
+         typename BACKING, std::size_t SLOT_ALIGN>
+bool operator==(const fixed_allocator<T, ELEMENTS, GROWTH, BACKING,
+                                      SLOT_ALIGN> &lhs,
+                const fixed_allocator<U, ELEMENTS, GROWTH, BACKING,
+                                      SLOT_ALIGN> &rhs)
+{
+  return lhs.pool() == rhs.pool();
+}
+
+/**
+ * @brief Inequality operator.
+ * @return true if the allocators have the different pools.
+ */
+template<typename T, typename U, std::size_t ELEMENTS, typename GROWTH,
+         typename BACKING, std::size_t SLOT_ALIGN>
+bool operator!=(const fixed_allocator<T, ELEMENTS, GROWTH, BACKING,
+                                      SLOT_ALIGN> &lhs,
+                const fixed_allocator<U, ELEMENTS, GROWTH, BACKING,
+                                      SLOT_ALIGN> &rhs)
+{
+  return !(lhs == rhs);
+}
+
 #endif  /* FIXEDALLOCATOR_HPP_ */
@@ -0,0 +1,801 @@
+/**
+ ******************************************************************************
+ * @file    flathashmap.hpp
+ * @author  Maxim <aveter@bk.ru>
+ * @date    27/06/2019
+ * @brief   Description of the template "Flat Hash Map".
+ ******************************************************************************
+ */
+
+#ifndef FLATHASHMAP_HPP_
+#define FLATHASHMAP_HPP_
+
+#include "backingpolicy.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <iterator>
+#include <memory>
+#include <new>
+#include <stdexcept>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+
+/* Forward ad */
+template<typename K, typename V, typename H, typename E, typename A>
+class flat_hash_map;
+
+
+/**
+ * Discription of the group of the control bytes of the hash table.
+ *
+ * The control byte of the slot is EMPTY, DELETED or the 7 low bits of the
+ * hash of the key for the full slot. The group of WIDTH bytes is compared at
+ * once with SSE2, or byte by byte where it is not available; the result is
+ * the bit mask of the matched slots.
+ */
+struct hash_group
+{
+  static constexpr std::size_t WIDTH = 16;    /**< - slots in the group */
+  static constexpr std::int8_t EMPTY = -128;  /**< - the slot never used */
+  static constexpr std::int8_t DELETED = -2;  /**< - the erased slot */
+
+  /**
+   * @brief Constructor with param.
+   * @param ctrl [in] - the control bytes of the group, aligned on WIDTH.
+   */
+  explicit hash_group(const std::int8_t *ctrl)
+#ifdef __SSE2__
+    : ctrl_(_mm_load_si128(reinterpret_cast<const __m128i *>(ctrl)))
+#else
+    : ctrl_(ctrl)
+#endif
+  {}
+
+  /**
+   * @brief The full slots with the same hash bits.
+   * @param h2 [in] - the 7 low bits of the hash.
+   * @return the bit mask of the slots.
+   */
+  std::uint32_t match(std::int8_t h2) const {
+#ifdef __SSE2__
+    return static_cast<std::uint32_t>(
+             _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_set1_epi8(h2), ctrl_)));
+#else
+    std::uint32_t mask = 0;
+    for (std::size_t i = 0; i < WIDTH; ++i)
+      if (ctrl_[i] == h2)
+        mask |= 1u << i;
+    return mask;
+#endif
+  }
+
+  /**
+   * @brief The empty slots, the probe stops on them.
+   * @return the bit mask of the slots.
+   */
+  std::uint32_t match_empty() const {
+    return match(EMPTY);
+  }
+
+  /**
+   * @brief The empty and the deleted slots, free for the insertion.
+   * @return the bit mask of the slots.
+   */
+  std::uint32_t match_free() const {
+#ifdef __SSE2__
+    return static_cast<std::uint32_t>(_mm_movemask_epi8(ctrl_));
+#else
+    std::uint32_t mask = 0;
+    for (std::size_t i = 0; i < WIDTH; ++i)
+      if (ctrl_[i] < 0)
+        mask |= 1u << i;
+    return mask;
+#endif
+  }
+
+
+  private:
+#ifdef __SSE2__
+    __m128i ctrl_;                /**< - the loaded control bytes */
+#else
+    const std::int8_t *ctrl_;     /**< - the control bytes */
+#endif
+};
+
+
+/**
+ * Discription of an iterator for working with the flat hash map.
+ *
+ * @tparam K - the type of the key.
+ * @tparam V - the type of the value.
+ * @tparam P - the type of the access to the item: const pair for the constant
+ *             iterator, pair for the mutable one.
+ */
+template<typename K, typename V, typename P>
+class flat_hash_map_iterator
+{
+  public:
+    /* Aliases */
+    using iterator_category = std::forward_iterator_tag;
+    using value_type = std::pair<const K, V>;
+    using difference_type = std::ptrdiff_t;
+    using pointer = P *;
+    using reference = P &;
+
+    /**
+     * @brief Constructor with param, skips the free slots.
+     * @param ctrl [in] - the control byte of the slot. Default ctrl = nullptr.
+     * @param slot [in] - the slot.
+     * @param end [in] - the end of the control bytes.
+     */
+    flat_hash_map_iterator(const std::int8_t *ctrl = nullptr,
+                           value_type *slot = nullptr,
+                           const std::int8_t *end = nullptr)
+      : ctrl_(ctrl), slot_(slot), end_(end) {
+      skip_free();
+    }
+
+    /**
+     * @brief Conversion of the mutable iterator to the constant one.
+     * @param other [in] - mutable iterator.
+     */
+    template<typename U, typename = typename std::enable_if<
+                           std::is_same<U, value_type>::value &&
+                           std::is_const<P>::value>::type>
+    flat_hash_map_iterator(const flat_hash_map_iterator<K, V, U> &other)
+      : ctrl_(other.ctrl_), slot_(other.slot_), end_(other.end_)
+    {}
+
+    /**
+     * @brief Inequality operator.
+     * @param  other [in] - iterator.
+     * @return true if the iterators are not equal and false otherwise.
+     */
+    bool operator!=(flat_hash_map_iterator const &other) const {
+      return ctrl_ != other.ctrl_;
+    }
+
+    /**
+     * @brief Comparison operator.
+     * @param other [in] - iterator
+     * @return true if equal and false otherwise.
+     */
+    bool operator==(flat_hash_map_iterator const &other) const {
+      return !(*this != other);
+    }
+
+    /**
+     * @brief Dereference operator.
+     * @return reference on the item.
+     */
+    P & operator*() const {
+      return *slot_;
+    }
+
+    /**
+     * @brief Pointer selector operator.
+     * @return pointer on the item.
+     */
+    P * operator->() const {
+      return slot_;
+    }
+
+    /**
+     * @brief Increment operator.
+     * @return increment data.
+     */
+    flat_hash_map_iterator & operator++() {
+      ++ctrl_;
+      ++slot_;
+      skip_free();
+      return *this;
+    }
+
+    /**
+     * @brief Postfix increment operator.
+     * @return the iterator before the increment.
+     */
+    flat_hash_map_iterator operator++(int) {
+      flat_hash_map_iterator tmp(*this);
+      ++(*this);
+      return tmp;
+    }
+
+
+  private:
+    const std::int8_t *ctrl_;   /**< - the control byte of the slot */
+    value_type *slot_;          /**< - the slot */
+    const std::int8_t *end_;    /**< - the end of the control bytes */
+
+    /* Friends */
+    template<typename, typename, typename>
+    friend class flat_hash_map_iterator;
+
+    /**
+     * @brief Move to the next full slot or to the end.
+     */
+    void skip_free() {
+      while (ctrl_ != end_ && *ctrl_ < 0) {
+        ++ctrl_;
+        ++slot_;
+      }
+    }
+};
+
+
+/**
+ * Swap the flat hash map.
+ *
+ * @tparam Kt - the type of the key.
+ * @tparam Vt - the type of the value.
+ * @tparam Hs - the hash of the keys.
+ * @tparam Eq - the equality of the keys.
+ * @tparam Aloc - allocator, memory manager for working with container.
+ * @param dst [in] - receiving container.
+ * @param src [out] - source container.
+ */
+template<typename Kt, typename Vt, typename Hs, typename Eq, typename Aloc>
+void swap(flat_hash_map<Kt, Vt, Hs, Eq, Aloc> &dst,
+          flat_hash_map<Kt, Vt, Hs, Eq, Aloc> &src)
+{
+  std::swap(dst.block_, src.block_);
+  std::swap(dst.ctrl_, src.ctrl_);
+  std::swap(dst.slots_, src.slots_);
+  std::swap(dst.capacity_, src.capacity_);
+  std::swap(dst.size_, src.size_);
+  std::swap(dst.growth_left_, src.growth_left_);
+  std::swap(dst.hash_, src.hash_);
+  std::swap(dst.eq_, src.eq_);
+  std::swap(dst.allocator, src.allocator);
+}
+
+
+/**
+ * Discription of the container "Flat Hash Map".
+ *
+ * The unordered map with the open addressing: the items are kept right in
+ * the slots of one table, the control byte of every slot keeps 7 bits of the
+ * hash. The lookup compares the group of 16 control bytes with the key hash
+ * by one SSE2 instruction and reads only the slots that match, the probe
+ * moves over the groups quadratically and stops on the group with the empty
+ * slot. The table is filled up to 7/8 and then doubled.
+ *
+ * The control bytes and the slots are one block of bytes from the allocator
+ * rebound to unsigned char, so there is no node per item and no separate
+ * bucket array. The block is taken larger by the alignment of the table and
+ * aligned inside. The table is one block of the growing size, which the pools
+ * of the small cells ("Fixed Allocator", "Arena Allocator") send to the heap
+ * anyway, so the allocator must be backing_allocator: the backing policy
+ * chooses the storage, mmap_backing puts the table on the huge pages. The
+ * insertion and the erasure invalidate the iterators, V must be movable.
+ * @tparam K - the type of the key.
+ * @tparam V - the type of the value.
+ * @tparam H - the hash of the keys. Default on std::hash<K>.
+ * @tparam E - the equality of the keys. Default on std::equal_to<K>.
+ * @tparam A - backing_allocator, memory manager for working with container.
+ *             Default on backing_allocator of heap_backing.
+ */
+template<typename K, typename V, typename H = std::hash<K>,
+         typename E = std::equal_to<K>,
+         typename A = backing_allocator<std::pair<const K, V>>>
+class flat_hash_map
+{
+  public:
+    /* Aliases */
+    using key_type = K;
+    using mapped_type = V;
+    using value_type = std::pair<const K, V>;
+    using allocator_t = typename std::allocator_traits<A>::template
+                          rebind_alloc<unsigned char>;
+    using iterator_t = flat_hash_map_iterator<K, V, value_type>;
+    using const_iterator_t = flat_hash_map_iterator<K, V, const value_type>;
+
+    static_assert(is_backing_allocator<allocator_t>::value,
+                  "The table is taken from the backing policy");
+
+    /**
+     * The default constructor, the table is allocated on the first insertion.
+     */
+    flat_hash_map() = default;
+
+    /**
+     * @brief Constructor with the number of items.
+     * @param count [in] - the number of items to insert without the rehash.
+     * @param hash [in] - the hash of the keys.
+     * @param eq [in] - the equality of the keys.
+     * @param alloc [in] - allocator, is rebound to the bytes of the table.
+     */
+    explicit flat_hash_map(std::size_t count, const H &hash = H(),
+                           const E &eq = E(), const A &alloc = A())
+      : hash_(hash), eq_(eq), allocator(alloc) {
+      reserve(count);
+    }
+
+    /**
+     * @brief Constructor with the memory manager.
+     * @param alloc [in] - allocator, is rebound to the bytes of the table.
+     */
+    explicit flat_hash_map(const A &alloc)
+      : allocator(alloc)
+    {}
+
+    /**
+     * The distructor
+     */
+    virtual ~flat_hash_map() {
+      clear();
+      drop_table(block_, capacity_);
+    }
+
+    /**
+     * @brief Copy constructor.
+     * @param other [in] - the object to copy.
+     */
+    flat_hash_map(const flat_hash_map &other)
+      : hash_(other.hash_), eq_(other.eq_),
+        allocator(static_cast<const allocator_t &>(
+                    std::allocator_traits<allocator_t>::
+                      select_on_container_copy_construction(other.allocator))) {
+      reserve(other.size_);
+      for (const value_type &item: other)
+        try_emplace(item.first, item.second);
+    }
+
+    /**
+     * @brief Move constructor.
+     * @param other [in] - the object to move.
+     */
+    flat_hash_map(flat_hash_map &&other)
+      : block_(other.block_), ctrl_(other.ctrl_), slots_(other.slots_),
+        capacity_(other.capacity_), size_(other.size_),
+        growth_left_(other.growth_left_), hash_(other.hash_), eq_(other.eq_),
+        allocator(std::move(other.allocator)) {
+      other.block_ = nullptr;
+      other.ctrl_ = nullptr;
+      other.slots_ = nullptr;
+      other.capacity_ = 0;
+      other.size_ = 0;
+      other.growth_left_ = 0;
+    }
+
+    /**
+     * @brief Copy operator.
+     * @param other [in] - the object to copy.
+     */
+    flat_hash_map & operator=(const flat_hash_map &other) {
+      if (this != &other) {
+        clear();
+        reserve(other.size_);
+        for (const value_type &item: other)
+          try_emplace(item.first, item.second);
+      }
+      return *this;
+    }
+
+    /**
+     * @brief Move operator.
+     * @param other [in] - the object to move.
+     */
+    flat_hash_map & operator=(flat_hash_map &&other) {
+      swap(*this, other);
+      return *this;
+    }
+
+    /**
+     * @brief  The begin iterator of the map.
+     * @return Returns an iterator to the first full slot.
+     */
+    iterator_t begin() {
+      return iterator_t(ctrl_, slots_, ctrl_ + capacity_);
+    }
+
+    /**
+     * @brief  The end iterator of the map.
+     * @return Returns an iterator to the end of the table.
+     */
+    iterator_t end() {
+      return iterator_t(ctrl_ + capacity_, slots_ + capacity_,
+                        ctrl_ + capacity_);
+    }
+
+    /**
+     * @brief  The begin iterator of the constant map.
+     * @return Returns an const iterator to the first full slot.
+     */
+    const_iterator_t begin() const {
+      return cbegin();
+    }
+
+    /**
+     * @brief  The end iterator of the constant map.
+     * @return Returns an const iterator to the end of the table.
+     */
+    const_iterator_t end() const {
+      return cend();
+    }
+
+    /**
+     * @brief  The const begin iterator of the map.
+     * @return Returns an const iterator to the first full slot.
+     */
+    const_iterator_t cbegin() const {
+      return const_cast<flat_hash_map *>(this)->begin();
+    }
+
+    /**
+     * @brief  The const end iterator of the map.
+     * @return Returns an const iterator to the end of the table.
+     */
+    const_iterator_t cend() const {
+      return const_cast<flat_hash_map *>(this)->end();
+    }
+
+    /**
+     * @brief The number of items in the map.
+     * @return The number of items.
+     */
+    std::size_t size() const {
+      return size_;
+    }
+
+    /**
+     * @brief Check that the map has no items.
+     * @return true if the map is empty, otherwise false.
+     */
+    bool empty() const {
+      return size_ == 0;
+    }
+
+    /**
+     * @brief The number of slots in the table.
+     * @return The number of slots.
+     */
+    std::size_t capacity() const {
+      return capacity_;
+    }
+
+    /**
+     * @brief Find the item.
+     * @param key [in] - the key.
+     * @return iterator to the item or end().
+     */
+    iterator_t find(const K &key) {
+      std::size_t idx = find_index(key, mix(hash_(key)));
+      return idx == NPOS ? end() : iterator_at(idx);
+    }
+
+    /**
+     * @brief Find the item.
+     * @param key [in] - the key.
+     * @return const iterator to the item or end().
+     */
+    const_iterator_t find(const K &key) const {
+      return const_cast<flat_hash_map *>(this)->find(key);
+    }
+
+    /**
+     * @brief Number of the items with the key.
+     * @param key [in] - the key.
+     * @return 1 if the item exists, otherwise 0.
+     */
+    std::size_t count(const K &key) const {
+      return find_index(key, mix(hash_(key))) == NPOS ? 0 : 1;
+    }
+
+    /**
+     * @brief Access to the value, the item is added if there is no key.
+     * @param key [in] - the key.
+     * @return reference to the value.
+     */
+    V & operator[](const K &key) {
+      return try_emplace(key).first->second;
+    }
+
+    /**
+     * @brief Access to the value, std::out_of_range is thrown if there is no
+     *        key.
+     * @param key [in] - the key.
+     * @return reference to the value.
+     */
+    V & at(const K &key) {
+      iterator_t it = find(key);
+      if (it == end())
+        throw std::out_of_range("flat_hash_map::at");
+      return it->second;
+    }
+
+    /**
+     * @brief Add the copy of the item if there is no key.
+     * @param item [in] - the item.
+     * @return iterator to the item with the key and true if it is added.
+     */
+    std::pair<iterator_t, bool> insert(const value_type &item) {
+      return try_emplace(item.first, item.second);
+    }
+
+    /**
+     * @brief Construct the value if there is no key.
+     * @tparam ...Args - params.
+     * @param key [in] - the key.
+     * @param args [in] - constructor params of the value.
+     * @return iterator to the item with the key and true if it is added.
+     */
+    template<typename... Args>
+    std::pair<iterator_t, bool> try_emplace(const K &key, Args &&... args) {
+      std::size_t hash = mix(hash_(key));
+      std::size_t idx = find_index(key, hash);
+      if (idx != NPOS)
+        return {iterator_at(idx), false};
+
+      if (growth_left_ == 0)
+        grow();
+
+      idx = find_free(hash);
+      ::new((void *) (slots_ + idx)) value_type(
+                std::piecewise_construct, std::forward_as_tuple(key),
+                std::forward_as_tuple(std::forward<Args>(args)...));
+      if (ctrl_[idx] == hash_group::EMPTY)
+        --growth_left_;
+      ctrl_[idx] = h2(hash);
+      ++size_;
+      return {iterator_at(idx), true};
+    }
+
+    /**
+     * @brief Remove the item.
+     *
+     * The slot becomes empty if its group has the empty slot, so the probe
+     * stops there anyway, otherwise it is marked as deleted and is reused by
+     * the insertion or cleaned by the rehash.
+     * @param key [in] - the key.
+     * @return number of the removed items.
+     */
+    std::size_t erase(const K &key) {
+      std::size_t idx = find_index(key, mix(hash_(key)));
+      if (idx == NPOS)
+        return 0;
+
+      slots_[idx].~value_type();
+      std::size_t group = idx - idx % hash_group::WIDTH;
+      if (hash_group(ctrl_ + group).match_empty()) {
+        ctrl_[idx] = hash_group::EMPTY;
+        ++growth_left_;
+      }
+      else
+        ctrl_[idx] = hash_group::DELETED;
+      --size_;
+      return 1;
+    }
+
+    /**
+     * @brief Remove all the items, the table is kept.
+     */
+    void clear() {
+      for (std::size_t i = 0; i < capacity_; ++i)
+        if (ctrl_[i] >= 0)
+          slots_[i].~value_type();
+      if (capacity_)
+        std::memset(ctrl_, static_cast<unsigned char>(hash_group::EMPTY),
+                    capacity_);
+      size_ = 0;
+      growth_left_ = max_load(capacity_);
+    }
+
+    /**
+     * @brief Prepare the table for the number of items, nothing is allocated
+     *        for no items.
+     * @param count [in] - the number of items to insert without the rehash.
+     */
+    void reserve(std::size_t count) {
+      if (count == 0)
+        return;
+
+      std::size_t cap = hash_group::WIDTH;
+      while (max_load(cap) < count)
+        cap *= 2;
+      if (cap > capacity_)
+        rehash(cap);
+    }
+
+
+  private:
+    static constexpr std::size_t NPOS = static_cast<std::size_t>(-1);
+
+    unsigned char *block_ = nullptr;  /**< - the block of the table */
+    std::int8_t *ctrl_ = nullptr;     /**< - the control bytes, aligned */
+    value_type *slots_ = nullptr;     /**< - the slots after ctrl_ */
+    std::size_t capacity_ = 0;        /**< - number of the slots */
+    std::size_t size_ = 0;            /**< - number of the items */
+    std::size_t growth_left_ = 0;     /**< - insertions in the empty slots
+                                             before the rehash */
+    H hash_{};                        /**< - the hash of the keys */
+    E eq_{};                          /**< - the equality of the keys */
+    allocator_t allocator{};          /**< - memory manager */
+
+    /* Friends function */
+    template<typename Kt, typename Vt, typename Hs, typename Eq,
+             typename Aloc>
+    friend void swap(flat_hash_map<Kt, Vt, Hs, Eq, Aloc> &dst,
+                     flat_hash_map<Kt, Vt, Hs, Eq, Aloc> &src);
+
+    /**
+     * @brief Spread the bits of the user hash, std::hash of the integers is
+     *        the identity.
+     * @param hash [in] - the user hash.
+     * @return the mixed hash.
+     */
+    static std::size_t mix(std::size_t hash) {
+      std::uint64_t val = static_cast<std::uint64_t>(hash) *
+                          0x9E3779B97F4A7C15ull;
+      return static_cast<std::size_t>(val ^ (val >> 32));
+    }
+
+    /**
+     * @brief The hash bits kept in the control byte.
+     * @param hash [in] - the mixed hash.
+     * @return the control byte of the full slot.
+     */
+    static std::int8_t h2(std::size_t hash) {
+      return static_cast<std::int8_t>(hash & 0x7F);
+    }
+
+    /**
+     * @brief Number of items in the table before the rehash.
+     * @param cap [in] - number of the slots.
+     * @return number of the items.
+     */
+    static std::size_t max_load(std::size_t cap) {
+      return cap - cap / 8;
+    }
+
+    /**
+     * @brief Offset of the slots in the block of the table.
+     * @param cap [in] - number of the slots.
+     * @return offset in bytes.
+     */
+    static std::size_t slots_offset(std::size_t cap) {
+      return (cap + alignof(value_type) - 1) / alignof(value_type) *
+             alignof(value_type);
+    }
+
+    /**
+     * @brief Alignment of the block of the table.
+     * @return alignment in bytes.
+     */
+    static constexpr std::size_t table_align() {
+      return std::max(hash_group::WIDTH, alignof(value_type));
+    }
+
+    /**
+     * @brief Size of the block of the table with the room for the alignment.
+     * @param cap [in] - number of the slots.
+     * @return size in bytes.
+     */
+    static std::size_t block_size(std::size_t cap) {
+      return slots_offset(cap) + cap * sizeof(value_type) + table_align() - 1;
+    }
+
+    /**
+     * @brief Release the block of the table, its items must be destroyed.
+     * @param block [in] - the block.
+     * @param cap [in] - number of the slots.
+     */
+    void drop_table(unsigned char *block, std::size_t cap) {
+      if (block != nullptr)
+        allocator.deallocate(block, block_size(cap));
+    }
+
+    /**
+     * @brief The iterator of the full slot.
+     * @param idx [in] - index of the slot.
+     * @return the iterator.
+     */
+    iterator_t iterator_at(std::size_t idx) {
+      return iterator_t(ctrl_ + idx, slots_ + idx, ctrl_ + capacity_);
+    }
+
+    /**
+     * @brief Find the slot of the key.
+     * @param key [in] - the key.
+     * @param hash [in] - the mixed hash of the key.
+     * @return index of the slot or NPOS.
+     */
+    std::size_t find_index(const K &key, std::size_t hash) const {
+      if (capacity_ == 0)
+        return NPOS;
+
+      std::size_t mask = capacity_ / hash_group::WIDTH - 1;
+      std::size_t group = (hash >> 7) & mask;
+      for (std::size_t step = 1; ; ++step) {
+        const std::int8_t *ctrl = ctrl_ + group * hash_group::WIDTH;
+        hash_group grp(ctrl);
+        for (std::uint32_t bits = grp.match(h2(hash)); bits; bits &= bits - 1) {
+          std::size_t idx = group * hash_group::WIDTH + __builtin_ctz(bits);
+          if (eq_(slots_[idx].first, key))
+            return idx;
+        }
+        if (grp.match_empty())
+          return NPOS;
+        group = (group + step) & mask;
+      }
+    }
+
+    /**
+     * @brief Find the first free slot on the probe of the hash, the table
+     *        must have one.
+     * @param hash [in] - the mixed hash of the key.
+     * @return index of the slot.
+     */
+    std::size_t find_free(std::size_t hash) const {
+      std::size_t mask = capacity_ / hash_group::WIDTH - 1;
+      std::size_t group = (hash >> 7) & mask;
+      for (std::size_t step = 1; ; ++step) {
+        std::uint32_t bits =
+                hash_group(ctrl_ + group * hash_group::WIDTH).match_free();
+        if (bits)
+          return group * hash_group::WIDTH + __builtin_ctz(bits);
+        group = (group + step) & mask;
+      }
+    }
+
+    /**
+     * @brief Make the room for the insertion: the table of many deleted slots
+     *        is cleaned in place, the full one is doubled.
+     */
+    void grow() {
+      if (capacity_ == 0)
+        rehash(hash_group::WIDTH);
+      else if (size_ < max_load(capacity_) / 2)
+        rehash(capacity_);
+      else
+        rehash(capacity_ * 2);
+    }
+
+    /**
+     * @brief Move the items to the new table.
+     * @param cap [in] - number of the slots, the power of 2 not less than
+     *                   the group.
+     */
+    void rehash(std::size_t cap) {
+      unsigned char *block = allocator.allocate(block_size(cap));
+      std::uintptr_t addr = reinterpret_cast<std::uintptr_t>(block);
+      addr = (addr + table_align() - 1) &
+             ~static_cast<std::uintptr_t>(table_align() - 1);
+      std::int8_t *ctrl = reinterpret_cast<std::int8_t *>(addr);
+      std::memset(ctrl, static_cast<unsigned char>(hash_group::EMPTY), cap);
+
+      unsigned char *old_block = block_;
+      std::int8_t *old_ctrl = ctrl_;
+      value_type *old_slots = slots_;
+      std::size_t old_cap = capacity_;
+
+      block_ = block;
+      ctrl_ = ctrl;
+      slots_ = reinterpret_cast<value_type *>(ctrl + slots_offset(cap));
+      capacity_ = cap;
+      growth_left_ = max_load(cap) - size_;
+
+      for (std::size_t i = 0; i < old_cap; ++i) {
+        if (old_ctrl[i] < 0)
+          continue;
+        std::size_t hash = mix(hash_(old_slots[i].first));
+        std::size_t idx = find_free(hash);
+        ::new((void *) (slots_ + idx)) value_type(std::move(old_slots[i]));
+        old_slots[i].~value_type();
+        ctrl_[idx] = h2(hash);
+      }
+      drop_table(old_block, old_cap);
+    }
+};
+
+#endif /* FLATHASHMAP_HPP_ */
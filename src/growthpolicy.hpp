@@ -0,0 +1,67 @@
+/**
+ ******************************************************************************
+ * @file    growthpolicy.hpp
+ * @author  Maxim <aveter@bk.ru>
+ * @date    12/05/2019
+ * @brief   Description of the growth policies for the "Chunk List".
+ ******************************************************************************
+ */
+
+#ifndef GROWTHPOLICY_HPP_
+#define GROWTHPOLICY_HPP_
+
+#include <cstddef>
+
+
+/**
+ * The memory is not growing, the buffer has a fixed size.
+ */
+struct no_growth
+{
+  /**
+   * @brief Size of the next block.
+   * @return always 0 - the next block is not allocated.
+   */
+  static constexpr std::size_t next_block(std::size_t) {
+    return 0;
+  }
+};
+
+
+/**
+ * Each next block has the same size as the previous one.
+ */
+struct linear_growth
+{
+  /**
+   * @brief Size of the next block.
+   * @param last [in] - size of the last allocated block.
+   * @return size of the next block.
+   */
+  static constexpr std::size_t next_block(std::size_t last) {
+    return last;
+  }
+};
+
+
+/**
+ * Each next block is FACTOR times larger than the previous one.
+ *
+ * @tparam FACTOR - the growth factor. Default on 2.
+ */
+template<std::size_t FACTOR = 2>
+struct geometric_growth
+{
+  static_assert(FACTOR > 0, "The growth factor must be positive");
+
+  /**
+   * @brief Size of the next block.
+   * @param last [in] - size of the last allocated block.
+   * @return size of the next block.
+   */
+  static constexpr std::size_t next_block(std::size_t last) {
+    return last * FACTOR;
+  }
+};
+
+#endif /* GROWTHPOLICY_HPP_ */
@@ -0,0 +1,210 @@
+/**
+ ******************************************************************************
+ * @file    inlineallocator.hpp
+ * @author  Maxim <aveter@bk.ru>
+ * @date    15/06/2019
+ * @brief   Description of the template "Inline Allocator".
+ ******************************************************************************
+ */
+
+#ifndef INLINEALLOCATOR_HPP_
+#define INLINEALLOCATOR_HPP_
+
+#include "backingpolicy.hpp"
+#include "chunklist.hpp"
+
+#include <cstddef>
+#include <functional>
+#include <new>
+#include <utility>
+
+
+/**
+ * Discription of the "Inline Allocator" class.
+ *
+ * The cells of ELEMENTS single objects are kept inside the allocator, so the
+ * container which holds the allocator by value (node_list, std::map) keeps
+ * its small data in its own object: the container on the stack does not touch
+ * the heap at all. The cells are handed out by the bump index and returned to
+ * the free list as in the "Chunk List".
+ *
+ * When the cells are filled and for the requests of several objects the
+ * system heap is used.
+ *
+ * The nodes refer to the storage of the allocator, so it can not be moved.
+ * The copy and the rebind start with their own empty storage, the allocator
+ * is equal only to itself: node_list is copied and moved item by item into
+ * the storage of the new list. The standard containers move the allocator on
+ * their copy and move, so they can be used with it but not copied or moved.
+ * @tparam T - data types.
+ * @tparam ELEMENTS - number of the objects kept inside.
+ */
+template<typename T, std::size_t ELEMENTS>
+class inline_allocator
+{
+  static_assert(ELEMENTS > 0, "The storage must not be empty");
+
+  public:
+    /* Aliases */
+    using value_type = T;
+    using pointer = T *;
+    using const_pointer = const T *;
+    using reference = T &;
+    using const_reference = const T &;
+
+    template<typename U>
+    struct rebind {
+      using other = inline_allocator<U, ELEMENTS>;
+    };
+
+    /* By default ... */
+    inline_allocator() = default;
+    ~inline_allocator() = default;
+
+    /**
+     * @brief Copy constructor.
+     *
+     * The cells belong to the source allocator, so the copy starts with its
+     * own empty storage.
+     */
+    inline_allocator(const inline_allocator &)
+      : inline_allocator()
+    {}
+
+    /**
+     * @brief Constructor of the allocator of the other type, used by the
+     *        containers to rebind it.
+     *
+     * Starts with its own empty storage, see the copy constructor.
+     */
+    template<typename U>
+    inline_allocator(const inline_allocator<U, ELEMENTS> &)
+      : inline_allocator()
+    {}
+
+    /**
+     * @brief Copy operator.
+     *
+     * Keeps its own storage, see the copy constructor.
+     */
+    inline_allocator & operator=(const inline_allocator &) {
+      return *this;
+    }
+
+    inline_allocator(inline_allocator &&) = delete;
+    inline_allocator & operator=(inline_allocator &&) = delete;
+
+    /**
+     * @brief allocation of a given "piece" of memory.
+     * @param n [in] - amount of memory requested.
+     * @return pointer to the allocated memory.
+     */
+    pointer allocate(std::size_t n) {
+      if (n == 1) {
+        cell_t *item = free_;
+        if (item != nullptr) {
+          free_ = item->next;
+          return reinterpret_cast<pointer>(item->value);
+        }
+        if (fresh_ < ELEMENTS)
+          return reinterpret_cast<pointer>(cells_[fresh_++].value);
+      }
+
+      ++fallback_count_;
+      return static_cast<pointer>(heap_backing::alloc(n * sizeof(T),
+                                                      alignof(T)));
+    }
+
+    /**
+     * @brief Release a specified amount of memory.
+     * @param p [in] - pointer to the beginning of the memory.
+     * @param n [in] - size of free memory.
+     */
+    void deallocate(pointer p, std::size_t n) {
+      if (n == 1 && is_inline(p)) {
+        cell_t *item = reinterpret_cast<cell_t *>(p);
+        item->next = free_;
+        free_ = item;
+        return;
+      }
+      heap_backing::release(p, n * sizeof(T), alignof(T));
+    }
+
+    /**
+     * @brief Number of the requests that went to the system heap.
+     * @return number of the requests.
+     */
+    std::size_t fallback_count() const {
+      return fallback_count_;
+    }
+
+    /**
+     * @brief Object construction.
+     * @tparam U - type of object constructed.
+     * @tparam Args - constructor parameters.
+     * @param p [in] - pointer of the object.
+     * @param args [in] - input parameters of the constructor.
+     */
+    template<class U, class... Args>
+    void construct(U *p, Args &&... args) {
+      ::new((void *) p) U(std::forward<Args>(args)...);
+    }
+
+    /**
+     * @brief Object distruction.
+     * @tparam U - type of object distroy.
+     * @param p [in] - pointer of the object.
+     */
+    template<class U>
+    void destroy(U *p) {
+      p->~U();
+    }
+
+
+  private:
+    using cell_t = chunk<T>;
+
+    cell_t cells_[ELEMENTS];            /**< - the storage, not initialized */
+    cell_t *free_ = nullptr;            /**< - head of the free list. */
+    std::size_t fresh_ = 0;             /**< - first never used cell. */
+    std::size_t fallback_count_ = 0;    /**< - requests to the heap */
+
+    /**
+     * @brief Check that the object is kept inside.
+     * @param p [in] - pointer to the object.
+     * @return true if the object is inside, otherwise false.
+     */
+    bool is_inline(pointer p) const {
+      std::less<const T *> less;
+      return !less(p, reinterpret_cast<const T *>(cells_[0].value)) &&
+             less(p, reinterpret_cast<const T *>(cells_ + ELEMENTS));
+    }
+};
+
+
+/**
+ * @brief Comparison operator.
+ *
+ * The cells of one allocator can be released only by itself, so the equal
+ * allocators are the same object.
+ * @return true if the allocators are the same object.
+ */
+template<typename T, typename U, std::size_t ELEMENTS>
+bool operator==(const inline_allocator<T, ELEMENTS> &lhs,
+                const inline_allocator<U, ELEMENTS> &rhs)
+{
+  return static_cast<const void *>(&lhs) == static_cast<const void *>(&rhs);
+}
+
+/**
+ * @brief Inequality operator.
+ * @return true if the allocators are the different objects.
+ */
+template<typename T, typename U, std::size_t ELEMENTS>
+bool operator!=(const inline_allocator<T, ELEMENTS> &lhs,
+                const inline_allocator<U, ELEMENTS> &rhs)
+{
+  return !(lhs == rhs);
+}
+
+#endif /* INLINEALLOCATOR_HPP_ */
@@ -7,6 +7,7 @@
  ******************************************************************************
  */
 
+#include "blockmap.hpp"
 #include "fixedallocator.hpp"
 #include "nodelist.hpp"
 
@@ -35,7 +36,7 @@ const size_t AMOUNT_OF_ELEMENTS = 10; /**< - the number of reserved items. */
 
 /* Aliases */
 using normal_map_t = std::map<int, int>;
-using fixed_map_t = std::map<int, int, std::less<int>,
+using fixed_map_t = block_map<int, int, std::less<int>,
                fixed_allocator<std::pair<const int, int>, AMOUNT_OF_ELEMENTS>>;
 using normal_node_list_t = node_list<int>;
 using fixed_node_list_t =
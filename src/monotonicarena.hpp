@@ -0,0 +1,317 @@
+/**
+ ******************************************************************************
+ * @file    monotonicarena.hpp
+ * @author  Maxim <aveter@bk.ru>
+ * @date    24/05/2019
+ * @brief   Description of the templates "Monotonic Arena" and "Monotonic
+ *          Allocator".
+ ******************************************************************************
+ */
+
+#ifndef MONOTONICARENA_HPP_
+#define MONOTONICARENA_HPP_
+
+#include "growthpolicy.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+
+/**
+ * Discription of the block of the monotonic arena.
+ *
+ * The data of the block is placed right after this header.
+ */
+struct monotonic_block
+{
+  monotonic_block *next;  /**< - pointer to the next block. */
+  std::size_t size;       /**< - size of the data of the block in bytes. */
+};
+
+
+/**
+ * Discription of the "Monotonic Arena" class.
+ *
+ * The allocation is the increment of the pointer in the current block, the
+ * deallocation does nothing. All the memory is freed at once by release() or
+ * reused from the beginning after reset(), so the structures built for one
+ * request cost nothing to tear down.
+ * @tparam BLOCK_SIZE - size of the first block in bytes.
+ * @tparam GROWTH - growth policy of the next blocks. Default on
+ *                  geometric_growth<>.
+ */
+template<std::size_t BLOCK_SIZE, typename GROWTH = geometric_growth<>>
+class monotonic_arena
+{
+  static_assert(BLOCK_SIZE > 0, "The block must not be empty");
+
+  public:
+    /**
+     * Constructor
+     */
+    monotonic_arena()
+      : head_(new_block(BLOCK_SIZE))
+    {
+      rewind(head_);
+    }
+
+    /**
+     * Virtual distructor
+     */
+    virtual ~monotonic_arena() {
+      free_blocks(head_);
+    }
+
+    monotonic_arena(const monotonic_arena &) = delete;
+    monotonic_arena & operator=(const monotonic_arena &) = delete;
+
+    /**
+     * @brief Allocate memory.
+     * @param bytes [in] - number of bytes.
+     * @param align [in] - alignment of the memory.
+     * @return pointer to the allocated memory.
+     */
+    void * alloc(std::size_t bytes, std::size_t align) {
+      std::uintptr_t res = align_up(cur_, align);
+      if (res + bytes > end_) {
+        next_block(bytes + align);
+        res = align_up(cur_, align);
+      }
+
+      cur_ = res + bytes;
+      return reinterpret_cast<void *>(res);
+    }
+
+    /**
+     * @brief Reuse all the blocks from the beginning.
+     *
+     * All the objects allocated before become invalid.
+     */
+    void reset() {
+      rewind(head_);
+    }
+
+    /**
+     * @brief Free all the blocks except the first one.
+     *
+     * All the objects allocated before become invalid.
+     */
+    void release() {
+      free_blocks(head_->next);
+      head_->next = nullptr;
+      last_size_ = head_->size;
+      rewind(head_);
+    }
+
+
+  private:
+    monotonic_block *head_;     /**< - the first block. */
+    monotonic_block *current_;  /**< - the block of the allocation. */
+    std::uintptr_t cur_;        /**< - first free byte of the block. */
+    std::uintptr_t end_;        /**< - end of the block. */
+    std::size_t last_size_ = BLOCK_SIZE;  /**< - size of the last block. */
+
+    /**
+     * @brief Allocate the new block.
+     * @param size [in] - size of the data of the block.
+     * @return pointer to the block.
+     */
+    static monotonic_block * new_block(std::size_t size) {
+      monotonic_block *blk = static_cast<monotonic_block *>(
+                               ::operator new(sizeof(monotonic_block) + size));
+      blk->next = nullptr;
+      blk->size = size;
+      return blk;
+    }
+
+    /**
+     * @brief Free the chain of the blocks.
+     * @param blk [in] - the first block of the chain.
+     */
+    static void free_blocks(monotonic_block *blk) {
+      while (blk) {
+        monotonic_block *next = blk->next;
+        ::operator delete(blk);
+        blk = next;
+      }
+    }
+
+    /**
+     * @brief Align the address.
+     * @param addr [in] - address.
+     * @param align [in] - alignment, the power of 2.
+     * @return aligned address.
+     */
+    static std::uintptr_t align_up(std::uintptr_t addr, std::size_t align) {
+      return (addr + align - 1) & ~static_cast<std::uintptr_t>(align - 1);
+    }
+
+    /**
+     * @brief Start the allocation from the beginning of the block.
+     * @param blk [in] - the block.
+     */
+    void rewind(monotonic_block *blk) {
+      current_ = blk;
+      cur_ = reinterpret_cast<std::uintptr_t>(blk + 1);
+      end_ = cur_ + blk->size;
+    }
+
+    /**
+     * @brief Switch to the next block which has enough space.
+     *
+     * The blocks kept after reset() are reused, otherwise the new block is
+     * allocated according to the growth policy.
+     * @param min_size [in] - required size of the data of the block.
+     */
+    void next_block(std::size_t min_size) {
+      if (current_->next != nullptr && current_->next->size >= min_size) {
+        rewind(current_->next);
+        return;
+      }
+
+      std::size_t size = GROWTH::next_block(last_size_);
+      if (size == 0)
+        throw std::bad_alloc();
+      if (size < min_size)
+        size = min_size;
+
+      monotonic_block *blk = new_block(size);
+      blk->next = current_->next;
+      current_->next = blk;
+      last_size_ = size;
+      rewind(blk);
+    }
+};
+
+
+/**
+ * Discription of the "Monotonic Allocator" class.
+ *
+ * The allocator refers to the arena which is owned by the user, so the arena
+ * must live longer than the containers. The copies and the rebinds share the
+ * arena, the deallocation does nothing.
+ * @tparam T - data types.
+ * @tparam ARENA - type of the arena. Default on monotonic_arena<4096>.
+ */
+template<typename T, typename ARENA = monotonic_arena<4096>>
+class monotonic_allocator
+{
+  public:
+    /* Aliases */
+    using value_type = T;
+    using pointer = T *;
+    using const_pointer = const T *;
+    using reference = T &;
+    using const_reference = const T &;
+    using arena_t = ARENA;
+
+    using propagate_on_container_copy_assignment = std::true_type;
+    using propagate_on_container_move_assignment = std::true_type;
+    using propagate_on_container_swap = std::true_type;
+    using is_always_equal = std::false_type;
+
+
+    template<typename U>
+    struct rebind {
+      using other = monotonic_allocator<U, ARENA>;
+    };
+
+    /**
+     * @brief Constructor with the arena.
+     * @param arena [in] - the arena of the memory.
+     */
+    explicit monotonic_allocator(ARENA &arena)
+      : arena_(&arena)
+    {}
+
+    /**
+     * @brief Converting constructor, the rebind shares the arena.
+     * @param other [in] - the allocator of the other type.
+     */
+    template<typename U>
+    monotonic_allocator(const monotonic_allocator<U, ARENA> &other)
+      : arena_(&other.arena())
+    {}
+
+    /* By default ... */
+    monotonic_allocator(const monotonic_allocator &) = default;
+    monotonic_allocator &operator=(const monotonic_allocator &) = default;
+    ~monotonic_allocator() = default;
+
+    /**
+     * @brief allocation of a given "piece" of memory.
+     * @param n [in] - amount of memory requested.
+     * @return pointer to the allocated memory.
+     */
+    pointer allocate(std::size_t n) {
+      return static_cast<pointer>(arena_->alloc(n * sizeof(T), alignof(T)));
+    }
+
+    /**
+     * @brief The memory is released only with the arena.
+     */
+    void deallocate(pointer, std::size_t)
+    {}
+
+    /**
+     * @brief Object construction.
+     * @tparam U - type of object constructed.
+     * @tparam Args - constructor parameters.
+     * @param p [in] - pointer of the object.
+     * @param args [in] - input parameters of the constructor.
+     */
+    template<class U, class... Args>
+    void construct(U *p, Args &&... args) {
+      ::new((void *) p) U(std::forward<Args>(args)...);
+    }
+
+    /**
+     * @brief Object distruction.
+     * @tparam U - type of object distroy.
+     * @param p [in] - pointer of the object.
+     */
+    template<class U>
+    void destroy(U *p) {
+      p->~U();
+    }
+
+    /**
+     * @brief The arena of the allocator.
+     * @return reference to the arena.
+     */
+    ARENA & arena() const {
+      return *arena_;
+    }
+
+
+  private:
+    ARENA *arena_;  /**< - the arena of the memory. */
+};
+
+
+/**
+ * @brief Comparison operator.
+ * @return true if the allocators share the arena.
+ */
+template<typename T, typename U, typename ARENA>
+bool operator==(const monotonic_allocator<T, ARENA> &lhs,
+                const monotonic_allocator<U, ARENA> &rhs)
+{
+  return &lhs.arena() == &rhs.arena();
+}
+
+/**
+ * @brief Inequality operator.
+ * @return true if the allocators have the different arenas.
+ */
+template<typename T, typename U, typename ARENA>
+bool operator!=(const monotonic_allocator<T, ARENA> &lhs,
+                const monotonic_allocator<U, ARENA> &rhs)
+{
+  return !(lhs == rhs);
+}
+
+#endif  /* MONOTONICARENA_HPP_ */
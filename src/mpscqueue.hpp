@@ -0,0 +1,153 @@
+/**
+ ******************************************************************************
+ * @file    mpscqueue.hpp
+ * @author  Maxim <aveter@bk.ru>
+ * @date    22/06/2019
+ * @brief   Description of the template "MPSC Queue".
+ ******************************************************************************
+ */
+
+#ifndef MPSCQUEUE_HPP_
+#define MPSCQUEUE_HPP_
+
+#include "chunklist.hpp"
+#include "concurrentallocator.hpp"
+#include "nodelist.hpp"
+
+#include <cstddef>
+#include <memory>
+#include <utility>
+
+
+/**
+ * Discription of the lock-free queue of many producers and one consumer.
+ *
+ * The queue is the singly linked list of the nodes of node_list. The
+ * producer links its node with one atomic exchange of the head, so the push
+ * is wait-free. The consumer takes the nodes from the tail, the first node is
+ * the stub: its value is already taken (or never constructed).
+ *
+ * The nodes are taken from the "Concurrent Allocator" by default: the
+ * producers allocate from their thread caches and the consumer returns the
+ * nodes to its own cache, so the hand-off does not touch the system heap.
+ * The pool is fixed: if the producers outrun the consumer by more than its
+ * capacity, the push throws std::bad_alloc.
+ * @tparam T - the type of the message.
+ * @tparam A - allocator, is rebound to the node type. Default on
+ *             concurrent_allocator<T, 65536>.
+ */
+template<typename T, typename A = concurrent_allocator<T, 65536>>
+class mpsc_queue
+{
+  public:
+    /* Aliases */
+    using node_t = node<T>;
+    using allocator_t =
+            typename std::allocator_traits<A>::template rebind_alloc<node_t>;
+
+    /**
+     * @brief Constructor.
+     * @param alloc [in] - allocator, is rebound to the node type.
+     */
+    explicit mpsc_queue(const A &alloc = A())
+      : allocator(alloc) {
+      node_t *stub = allocator.allocate(1);
+      stub->next = nullptr;
+      head_ = stub;
+      tail_ = stub;
+    }
+
+    /**
+     * Virtual distructor, drops the messages left in the queue.
+     */
+    virtual ~mpsc_queue() {
+      node_t *cur = tail_;
+      node_t *next = cur->next;
+      allocator.deallocate(cur, 1);
+
+      while (next) {
+        cur = next;
+        next = cur->next;
+        allocator.destroy(&cur->value);
+        allocator.deallocate(cur, 1);
+      }
+    }
+
+    mpsc_queue(const mpsc_queue &) = delete;
+    mpsc_queue & operator=(const mpsc_queue &) = delete;
+
+    /**
+     * @brief Add the message, called by any thread.
+     * @tparam ...Args - params.
+     * @param args [in] - constructor params of the message.
+     */
+    template<typename... Args>
+    void emplace(Args &&... args) {
+      node_t *new_node = allocator.allocate(1);
+      try {
+        allocator.construct(new_node, std::forward<Args>(args)...);
+      }
+      catch (...) {
+        allocator.deallocate(new_node, 1);
+        throw;
+      }
+
+      node_t *prev = __atomic_exchange_n(&head_, new_node, __ATOMIC_ACQ_REL);
+      __atomic_store_n(&prev->next, new_node, __ATOMIC_RELEASE);
+    }
+
+    /**
+     * @brief Add the copy of the message, called by any thread.
+     * @param value [in] - the message.
+     */
+    void push(const T &value) {
+      emplace(value);
+    }
+
+    /**
+     * @brief Add the message, called by any thread.
+     * @param value [in] - the message to move.
+     */
+    void push(T &&value) {
+      emplace(std::move(value));
+    }
+
+    /**
+     * @brief Take the oldest message, called by the consumer only.
+     *
+     * The message of the producer which has exchanged the head, but has not
+     * linked the node yet, is not visible: the queue looks empty for a moment.
+     * @param value [out] - the message.
+     * @return true if the message is taken, false if the queue is empty.
+     */
+    bool try_pop(T &value) {
+      node_t *stub = tail_;
+      node_t *next = __atomic_load_n(&stub->next, __ATOMIC_ACQUIRE);
+      if (next == nullptr)
+        return false;
+
+      value = std::move(next->value);
+      allocator.destroy(&next->value);
+      tail_ = next;
+      allocator.deallocate(stub, 1);
+      return true;
+    }
+
+    /**
+     * @brief Check that the queue has no linked messages, called by the
+     *        consumer only.
+     * @return true if the queue is empty, otherwise false.
+     */
+    bool empty() const {
+      return __atomic_load_n(&tail_->next, __ATOMIC_ACQUIRE) == nullptr;
+    }
+
+
+  private:
+    alignas(CACHE_LINE_SIZE) node_t *head_;   /**< - the newest node, the
+                                                     producers. */
+    alignas(CACHE_LINE_SIZE) node_t *tail_;   /**< - the stub, the consumer */
+    allocator_t allocator;                    /**< - memory manager */
+};
+
+#endif /* MPSCQUEUE_HPP_ */
@@ -10,9 +10,16 @@
 #ifndef NODELIST_H_
 #define NODELIST_H_
 
+#include <algorithm>
 #include <cstddef>
+#include <functional>
 #include <iostream>
+#include <iterator>
 #include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
 
 
 /* Forward ad */
@@ -47,11 +54,20 @@ struct node {
  * Discription of an iterator for working with a single-linked list.
  *
  * @tparam T - the type of variable stored in the node.
+ * @tparam V - the type of the access to the value: const T for the constant
+ *             iterator, T for the mutable one. Default on const T.
  */
-template<typename T>
-class node_iterator : public std::iterator<std::input_iterator_tag, T>
+template<typename T, typename V = const T>
+class node_iterator
 {
   public:
+    /* Aliases */
+    using iterator_category = std::forward_iterator_tag;
+    using value_type = T;
+    using difference_type = std::ptrdiff_t;
+    using pointer = V *;
+    using reference = V &;
+
     /**
      * @brief Constructor with param.
      * @param p [in] - pointer to a single-linked list. Default p = nullptr.
@@ -60,6 +76,17 @@ class node_iterator : public std::iterator<std::input_iterator_tag, T>
       : ptr_(p)
     {}
 
+    /**
+     * @brief Conversion of the mutable iterator to the constant one.
+     * @param other [in] - mutable iterator.
+     */
+    template<typename U, typename = typename std::enable_if<
+                           std::is_same<U, T>::value &&
+                           std::is_const<V>::value>::type>
+    node_iterator(const node_iterator<U, U> &other)
+      : ptr_(other.ptr_)
+    {}
+
     /**
      * @brief Inequality operator.
      * @param  other [in] - iterator.
@@ -82,7 +109,7 @@ class node_iterator : public std::iterator<std::input_iterator_tag, T>
      * @brief Dereference operator.
      * @return reference on the data.
      */
-    const T & operator*() const {
+    V & operator*() const {
       return ptr_->value;
     }
 
@@ -90,7 +117,7 @@ class node_iterator : public std::iterator<std::input_iterator_tag, T>
      * @brief Pointer selector operator.
      * @return pointer on the data.
      */
-    const T * operator->() const {
+    V * operator->() const {
       return &(ptr_->value);
     }
 
@@ -104,60 +131,122 @@ class node_iterator : public std::iterator<std::input_iterator_tag, T>
       return *this;
     }
 
+    /**
+     * @brief Postfix increment operator.
+     * @return the iterator before the increment.
+     */
+    node_iterator operator++(int) {
+      node_iterator tmp(*this);
+      ++(*this);
+      return tmp;
+    }
+
 
   private:
     node<T> *ptr_{nullptr};   /**< - pointer to a single-linked list. */
 
+    /* Friends */
+    template<typename, typename>
+    friend class node_iterator;
+
+    template<typename, typename>
+    friend class ::node_list;
 };
 
+} /* namespace */
+
 
 /**
  * Swap the node list.
  *
  * @tparam Tp - the type of variable stored in the node.
- * @tparam Aloc - allocator, memory manager for working with container. Default
- *                on std::allocator.
+ * @tparam Aloc - allocator, memory manager for working with container.
  * @param dst [in] - receiving container.
  * @param src [out] - source container.
  */
-template<typename Tp, typename Aloc = std::allocator<node<Tp>>>
+template<typename Tp, typename Aloc>
 void swap(node_list<Tp, Aloc> &dst, node_list<Tp, Aloc> &src)
 {
   std::swap(dst.head_, src.head_);
+  std::swap(dst.tail_, src.tail_);
   std::swap(dst.allocator, src.allocator);
   std::swap(dst.size_, src.size_);
 }
 
 
 /**
- * Copying the nodes.
+ * Check that the allocator hands out and takes back several objects in one
+ * call: allocate_bulk(pointer *, n) and deallocate_bulk(pointer *, n).
  *
- * @tparam Tp - the type of variable stored in the node.
- * @tparam Aloc - allocator, memory manager for working with container. Default
- *                on std::allocator.
- * @param dst [in] - reference to the source node list.
- * @param src [out] - reference to the source node list.
+ * @tparam A - the type of the allocator.
  */
-template<typename Tp, typename Aloc = std::allocator<node<Tp>>>
-void copy(node_list<Tp, Aloc> &dst, const node_list<Tp, Aloc> &src)
-{
-  dst.head_ = src.head_;
-  dst.size_ = src.size_;
-  dst.allocator = src.allocator;
-
-  node<Tp> *cur_other = src.head_;
-  while (cur_other) {
-    dst->push_back(cur_other->value);
-    cur_other = cur_other->next;
-  }
-}
+template<typename A, typename = void>
+struct has_bulk_allocate : std::false_type {};
 
-} /* namespace */
+template<typename A>
+struct has_bulk_allocate<A, std::void_t<
+    decltype(std::declval<A &>().allocate_bulk(
+               std::declval<typename A::value_type **>(), std::size_t())),
+    decltype(std::declval<A &>().deallocate_bulk(
+               std::declval<typename A::value_type **>(), std::size_t()))>>
+  : std::true_type {};
+
+
+/**
+ * Check that the allocator hands out several objects in its never used
+ * memory: allocate_fresh(pointer *, n).
+ *
+ * @tparam A - the type of the allocator.
+ */
+template<typename A, typename = void>
+struct has_fresh_allocate : std::false_type {};
+
+template<typename A>
+struct has_fresh_allocate<A, std::void_t<
+    decltype(std::declval<A &>().allocate_fresh(
+               std::declval<typename A::value_type **>(), std::size_t()))>>
+  : std::true_type {};
+
+
+/**
+ * Check that the allocators can be compared: a == b.
+ *
+ * @tparam A - the type of the allocator.
+ */
+template<typename A, typename = void>
+struct has_allocator_equal : std::false_type {};
+
+template<typename A>
+struct has_allocator_equal<A, std::void_t<
+    decltype(std::declval<const A &>() == std::declval<const A &>())>>
+  : std::true_type {};
 
 
 /**
  * Discription of the container for working with a single-linked list.
  *
+ * The list keeps the pointer to the last node, so adding to the both ends is
+ * O(1). The splice and the merge are O(1) (the merge is one pass) and keep
+ * the nodes only if the allocators of the lists are equal (or always equal),
+ * or if this list is empty: it takes the allocator of the other list with
+ * the nodes. Otherwise the memory of the other list can not be released by
+ * this one, so the values are moved one by one into the new nodes of this
+ * list. The copies of fixed_allocator are never equal, so the lists that
+ * splice into the non-empty list share the pool with arena_allocator or
+ * pool_resource instead.
+ *
+ * The move of the list takes the nodes with the allocator. The allocator which
+ * can not be moved (inline_allocator keeps the nodes inside) is copied
+ * instead, and the values are moved one by one into its new nodes.
+ *
+ * The range constructor, assign() and append() take the nodes from the
+ * allocator in batches (allocate_bulk() if the allocator has it) and link
+ * them in one pass, clear() returns them in batches too.
+ *
+ * compact() moves the values into the new run of the nodes (allocate_fresh()
+ * if the allocator has it) so that the list order is the order of the
+ * addresses of the nodes, the traversal then reads the memory forward.
+ * compact_step() does it in place by parts.
  * @tparam T - the type of variable stored in the node.
  * @tparam A - allocator, memory manager for working with container. Default on
  *             std::allocator.
@@ -170,40 +259,85 @@ class node_list
     using node_t = node<T>;
     using allocator_t =
             typename std::allocator_traits<A>::template rebind_alloc<node_t>;
-    using iterator_t = node_iterator<T>;
-    using const_iterator_t = const node_iterator<T>;
+    using iterator_t = node_iterator<T, T>;
+    using const_iterator_t = node_iterator<T, const T>;
 
     /**
      * The default constructor.
      */
     node_list() = default;
 
+    /**
+     * @brief Constructor with the memory manager.
+     * @param alloc [in] - allocator, is rebound to the node type.
+     */
+    explicit node_list(const A &alloc)
+      : allocator(alloc)
+    {}
+
+    /**
+     * @brief Constructor with the copies of the range.
+     * @tparam InputIt - type of the iterator.
+     * @param first [in] - the beginning of the range.
+     * @param last [in] - the end of the range.
+     */
+    template<typename InputIt, typename = typename
+               std::iterator_traits<InputIt>::iterator_category>
+    node_list(InputIt first, InputIt last) {
+      append_range(first, last);
+    }
+
+    /**
+     * @brief Constructor with the copies of the range and the memory manager.
+     * @tparam InputIt - type of the iterator.
+     * @param first [in] - the beginning of the range.
+     * @param last [in] - the end of the range.
+     * @param alloc [in] - allocator, is rebound to the node type.
+     */
+    template<typename InputIt, typename = typename
+               std::iterator_traits<InputIt>::iterator_category>
+    node_list(InputIt first, InputIt last, const A &alloc)
+      : allocator(alloc) {
+      append_range(first, last);
+    }
+
     /**
      * The distructor
      */
     virtual ~node_list() {
-      while (head_) {
-        node_t *next = head_->next;
-        allocator.destroy(&head_->value);
-        allocator.deallocate(head_, 1);
-        head_ = next;
-      }
+      clear();
     }
 
     /**
      * @brief Copy constructor.
      * @param other [in] - the object to copy.
      */
-    node_list(const node_list &other) {
-      copy(this, other);
+    node_list(const node_list &other)
+      /* copied from the selected one, the allocator may be unmovable */
+      : allocator(static_cast<const allocator_t &>(
+                    std::allocator_traits<allocator_t>::
+                      select_on_container_copy_construction(other.allocator))) {
+      for (node_t *cur = other.head_; cur; cur = cur->next)
+        push_back(cur->value);
     }
 
     /**
      * @brief Move constructor.
+     *
+     * The other list becomes empty, see the move of the allocator which can not
+     * be moved in the description of the class.
      * @param other [in] - the object to move.
      */
-    node_list(node_list &&other) {
-      swap(this, other);
+    node_list(node_list &&other)
+      : allocator(take_allocator(other.allocator)) {
+      if constexpr (std::is_move_constructible<allocator_t>::value) {
+        size_ = other.size_;
+        head_ = other.head_;
+        tail_ = other.tail_;
+        other.release();
+      }
+      else
+        move_items(other);
     }
 
     /**
@@ -211,7 +345,11 @@ class node_list
      * @param other [in] - the object to copy.
      */
     node_list & operator=(const node_list & other) {
-      copy(this, other);
+      if (this != &other) {
+        clear();
+        for (node_t *cur = other.head_; cur; cur = cur->next)
+          push_back(cur->value);
+      }
       return *this;
     }
 
@@ -220,7 +358,13 @@ class node_list
      * @param other [in] - the object to move.
      */
     node_list & operator=(node_list &&other) {
-      swap(this, other);
+      if constexpr (std::is_move_constructible<allocator_t>::value &&
+                    std::is_move_assignable<allocator_t>::value)
+        swap(*this, other);
+      else if (this != &other) {
+        clear();
+        move_items(other);
+      }
       return *this;
     }
 
@@ -240,6 +384,22 @@ class node_list
       return iterator_t();
     }
 
+    /**
+     * @brief  The begin iterator of the constant node list.
+     * @return Returns an const iterator to the beginning of the node list.
+     */
+    const_iterator_t begin() const {
+      return cbegin();
+    }
+
+    /**
+     * @brief  The end iterator of the constant node list.
+     * @return Returns an const iterator to the end of the node list.
+     */
+    const_iterator_t end() const {
+      return cend();
+    }
+
     /**
      * @brief  The const begin iterator of the node list.
      * @return Returns an const iterator to the beginning of the node list.
@@ -258,10 +418,34 @@ class node_list
      * @brief The number of data in the node list.
      * @return The number of data.
      */
-    std::size_t size() {
+    std::size_t size() const {
       return size_;
     }
 
+    /**
+     * @brief Check that the list has no data.
+     * @return true if the list is empty, otherwise false.
+     */
+    bool empty() const {
+      return size_ == 0;
+    }
+
+    /**
+     * @brief The first item of the list, the list must not be empty.
+     * @return reference to the data.
+     */
+    T & front() {
+      return head_->value;
+    }
+
+    /**
+     * @brief The last item of the list, the list must not be empty.
+     * @return reference to the data.
+     */
+    T & back() {
+      return tail_->value;
+    }
+
     /**
      * @brief Add an item to the top of the list (variable number of params).
      * @tparam ...Args - params.
@@ -269,9 +453,7 @@ class node_list
      */
     template<typename... Args>
     void push_front(Args &&... args) {
-      node_t *new_node = allocator.allocate(1);
-      allocator.construct(new_node, std::forward<Args>(args)...);
-      push_front_helper(new_node);
+      emplace_front(std::forward<Args>(args)...);
     }
 
     /**
@@ -281,42 +463,710 @@ class node_list
      */
     template<typename... Args>
     void push_back(Args &&... args) {
-      node_t *new_node = allocator.allocate(1);
-      allocator.construct(new_node, std::forward<Args>(args)...);
+      emplace_back(std::forward<Args>(args)...);
+    }
+
+    /**
+     * @brief Construct an item at the top of the list.
+     * @tparam ...Args - params.
+     * @param args [in] - constructor params of the value.
+     * @return iterator to the new item.
+     */
+    template<typename... Args>
+    iterator_t emplace_front(Args &&... args) {
+      node_t *new_node = make_node(std::forward<Args>(args)...);
+      push_front_helper(new_node);
+      return iterator_t(new_node);
+    }
+
+    /**
+     * @brief Construct an item at the back of the list.
+     * @tparam ...Args - params.
+     * @param args [in] - constructor params of the value.
+     * @return iterator to the new item.
+     */
+    template<typename... Args>
+    iterator_t emplace_back(Args &&... args) {
+      node_t *new_node = make_node(std::forward<Args>(args)...);
       push_back_helper(new_node);
+      return iterator_t(new_node);
+    }
+
+    /**
+     * @brief Construct an item after the given one.
+     * @tparam ...Args - params.
+     * @param pos [in] - iterator to the item of the list.
+     * @param args [in] - constructor params of the value.
+     * @return iterator to the new item.
+     */
+    template<typename... Args>
+    iterator_t emplace_after(const_iterator_t pos, Args &&... args) {
+      node_t *new_node = make_node(std::forward<Args>(args)...);
+      link_after(pos.ptr_, new_node, new_node, 1);
+      return iterator_t(new_node);
+    }
+
+    /**
+     * @brief Insert a copy of the value after the given item.
+     * @param pos [in] - iterator to the item of the list.
+     * @param value [in] - the value.
+     * @return iterator to the new item.
+     */
+    iterator_t insert_after(const_iterator_t pos, const T &value) {
+      return emplace_after(pos, value);
+    }
+
+    /**
+     * @brief Insert the value after the given item.
+     * @param pos [in] - iterator to the item of the list.
+     * @param value [in] - the value to move.
+     * @return iterator to the new item.
+     */
+    iterator_t insert_after(const_iterator_t pos, T &&value) {
+      return emplace_after(pos, std::move(value));
+    }
+
+    /**
+     * @brief Replace the items with the copies of the range.
+     * @tparam InputIt - type of the iterator.
+     * @param first [in] - the beginning of the range.
+     * @param last [in] - the end of the range.
+     */
+    template<typename InputIt, typename = typename
+               std::iterator_traits<InputIt>::iterator_category>
+    void assign(InputIt first, InputIt last) {
+      clear();
+      append_range(first, last);
+    }
+
+    /**
+     * @brief Add the items constructed from the same params to the back.
+     * @tparam ...Args - params.
+     * @param count [in] - number of the items.
+     * @param args [in] - constructor params of every value.
+     */
+    template<typename... Args>
+    void append(std::size_t count, const Args &... args) {
+      append_bulk(count, [&](node_t *ptr) {
+        allocator.construct(ptr, args...);
+      });
+    }
+
+    /**
+     * @brief Remove the first item, the list must not be empty.
+     */
+    void pop_front() {
+      node_t *old = head_;
+      head_ = old->next;
+      if (head_ == nullptr)
+        tail_ = nullptr;
+      --size_;
+      drop_node(old);
+    }
+
+    /**
+     * @brief Remove the item following the given one.
+     * @param pos [in] - iterator to the item of the list.
+     * @return iterator to the item following the removed one.
+     */
+    iterator_t erase_after(const_iterator_t pos) {
+      node_t *prev = pos.ptr_;
+      node_t *old = prev->next;
+      if (old == nullptr)
+        return end();
+
+      prev->next = old->next;
+      if (tail_ == old)
+        tail_ = prev;
+      --size_;
+      drop_node(old);
+      return iterator_t(prev->next);
+    }
+
+    /**
+     * @brief Remove all the items.
+     */
+    void clear() {
+      drop_chain(head_);
+      head_ = nullptr;
+      tail_ = nullptr;
+      size_ = 0;
+    }
+
+    /**
+     * @brief Move all the items of the other list after the given item.
+     * @param pos [in] - iterator to the item of the list.
+     * @param other [in] - the list to move, it becomes empty.
+     */
+    void splice_after(const_iterator_t pos, node_list &other) {
+      if (other.head_ == nullptr)
+        return;
+
+      node_t *first, *last;
+      std::size_t count = take_nodes(other, first, last);
+      link_after(pos.ptr_, first, last, count);
+    }
+
+    /**
+     * @brief Move all the items of the other list to the top of the list.
+     * @param other [in] - the list to move, it becomes empty.
+     */
+    void splice_front(node_list &other) {
+      if (other.head_ == nullptr)
+        return;
+
+      node_t *first, *last;
+      std::size_t count = take_nodes(other, first, last);
+      last->next = head_;
+      if (tail_ == nullptr)
+        tail_ = last;
+      head_ = first;
+      size_ += count;
+    }
+
+    /**
+     * @brief Move all the items of the other list to the back of the list.
+     * @param other [in] - the list to move, it becomes empty.
+     */
+    void splice_back(node_list &other) {
+      if (other.head_ == nullptr)
+        return;
+
+      node_t *first, *last;
+      std::size_t count = take_nodes(other, first, last);
+      link_back(first, last, count);
+    }
+
+    /**
+     * @brief Merge two sorted lists into one sorted list.
+     * @param other [in] - the sorted list to merge, it becomes empty.
+     */
+    void merge(node_list &other) {
+      merge(other, std::less<T>());
+    }
+
+    /**
+     * @brief Merge two sorted lists into one sorted list.
+     * @tparam Compare - type of the comparator.
+     * @param other [in] - the sorted list to merge, it becomes empty.
+     * @param comp [in] - the comparator the lists are sorted with.
+     */
+    template<typename Compare>
+    void merge(node_list &other, Compare comp) {
+      if (this == &other || other.head_ == nullptr)
+        return;
+
+      node_t *first, *other_tail;
+      std::size_t count = take_nodes(other, first, other_tail);
+      node_t *a = head_;
+      node_t *b = first;
+      node_t *last = nullptr;
+      head_ = nullptr;
+
+      while (a && b) {
+        node_t *item;
+        if (comp(b->value, a->value)) {
+          item = b;
+          b = b->next;
+        }
+        else {
+          item = a;
+          a = a->next;
+        }
+
+        if (last == nullptr)
+          head_ = item;
+        else
+          last->next = item;
+        last = item;
+      }
+
+      node_t *rest = a ? a : b;
+      if (last == nullptr)
+        head_ = rest;
+      else
+        last->next = rest;
+      if (b != nullptr)
+        tail_ = other_tail;
+
+      size_ += count;
+    }
+
+    /**
+     * @brief Put the values in the order of the addresses of the nodes.
+     *
+     * The new nodes are taken at once, from the never used cells of the pool
+     * if the allocator has allocate_fresh(), so they form the contiguous run.
+     * The values are moved into them in the list order (copied if the move of
+     * T can throw), the nodes are linked in the order of their addresses and
+     * the old ones are released. If the copy throws, the list is unchanged.
+     *
+     * If the allocator can not give the new nodes and the move of T does not
+     * throw, the list is compacted in place, see compact_step().
+     * The iterators and the references to the items are invalidated.
+     */
+    void compact() {
+      if (size_ < 2)
+        return;
+
+      std::vector<node_t *> nodes(size_);
+      try {
+        allocate_run(nodes.data(), size_);
+      }
+      catch (const std::bad_alloc &) {
+        if constexpr (std::is_nothrow_move_constructible<T>::value) {
+          compact_step(end(), size_);
+          return;
+        }
+        else
+          throw;
+      }
+      std::sort(nodes.begin(), nodes.end(), std::less<node_t *>());
+
+      std::size_t built = 0;
+      try {
+        for (node_t *cur = head_; cur; cur = cur->next, ++built)
+          allocator.construct(&nodes[built]->value,
+                              std::move_if_noexcept(cur->value));
+      }
+      catch (...) {
+        for (std::size_t i = 0; i < built; ++i)
+          allocator.destroy(&nodes[i]->value);
+        deallocate_nodes(nodes.data(), nodes.size());
+        throw;
+      }
+
+      for (std::size_t i = 0; i + 1 < built; ++i)
+        nodes[i]->next = nodes[i + 1];
+      nodes[built - 1]->next = nullptr;
+      drop_chain(head_);
+      head_ = nodes.front();
+      tail_ = nodes.back();
+    }
+
+    /**
+     * @brief Put the values of the part of the list in the order of the
+     *        addresses of its own nodes.
+     *
+     * Nothing is allocated from the pool: the values are moved between the
+     * nodes of the part (the move of T must not throw) and the nodes are
+     * relinked in the order of their addresses. Only the nodes of one step
+     * are sorted, the steps follow each other in the list order.
+     *
+     * The pause is bounded by the number of the items, the list is passed by
+     * the series of the calls:
+     *
+     *     auto pos = list.end();
+     *     do
+     *       pos = list.compact_step(pos, 256);
+     *     while (pos != list.end());
+     *
+     * The list must not be changed between the calls of the series.
+     * @param pos [in] - the last item of the previous step, end() to start
+     *                   from the head.
+     * @param count [in] - number of the items to reorder.
+     * @return the position of the next step, end() if the list is passed.
+     */
+    iterator_t compact_step(const_iterator_t pos, std::size_t count) {
+      static_assert(std::is_nothrow_move_constructible<T>::value,
+                    "The values are moved in place, the move must not throw");
+
+      node_t *prev = pos.ptr_;
+      node_t *first = prev ? prev->next : head_;
+
+      std::vector<node_t *> nodes;
+      nodes.reserve(count < size_ ? count : size_);
+      for (node_t *cur = first; cur && nodes.size() < count; cur = cur->next)
+        nodes.push_back(cur);
+      if (nodes.empty())
+        return end();
+
+      node_t *next = nodes.back()->next;
+      node_t *last = reorder(nodes);
+      if (prev)
+        prev->next = nodes.front();
+      else
+        head_ = nodes.front();
+      last->next = next;
+      if (next == nullptr) {
+        tail_ = last;
+        return end();
+      }
+      return iterator_t(last);
     }
 
 
   private:
+    /** Number of the nodes taken from the allocator in one call. */
+    static constexpr std::size_t BULK_BATCH = 64;
+
     std::size_t size_ = 0;    /**< - number of data in the node list */
     node_t *head_ = nullptr;  /**< - pointer to the head on the list */
+    node_t *tail_ = nullptr;  /**< - pointer to the tail on the list */
     allocator_t allocator{};  /**< - memory manager */
 
     /* Friends function */
     template<typename Tp, typename Aloc>
     friend void swap(node_list<Tp, Aloc> &dst, node_list<Tp, Aloc> &src);
 
-    template<typename Tp, typename Aloc>
-    friend void copy(node_list<Tp, Aloc> &dst, const node_list<Tp, Aloc> &src);
+    /**
+     * @brief Allocate and construct the node.
+     * @tparam ...Args - params.
+     * @param args [in] - constructor params of the value.
+     * @return pointer to the new node.
+     */
+    template<typename... Args>
+    node_t * make_node(Args &&... args) {
+      node_t *new_node = allocator.allocate(1);
+      allocator.construct(new_node, std::forward<Args>(args)...);
+      return new_node;
+    }
 
     /**
-     * @brief The push_back helper function.
-     * @param ptr_new_node [in] - pointer to the new node.
+     * @brief Destroy and deallocate the node.
+     * @param ptr_node [in] - pointer to the node.
      */
-    void push_back_helper(node_t * const ptr_new_node) {
-      if (head_ == nullptr)
-        head_ = ptr_new_node;
+    void drop_node(node_t *ptr_node) {
+      allocator.destroy(&ptr_node->value);
+      allocator.deallocate(ptr_node, 1);
+    }
+
+    /**
+     * @brief Allocate the nodes, all or none.
+     * @param nodes [out] - pointers to the nodes.
+     * @param count [in] - number of the nodes.
+     */
+    void allocate_nodes(node_t **nodes, std::size_t count) {
+      if constexpr (has_bulk_allocate<allocator_t>::value)
+        allocator.allocate_bulk(nodes, count);
       else {
-        node_t *next_node = head_->next;
-        if (next_node == nullptr)
-          head_->next = ptr_new_node;
-        else {
-          while (next_node->next)
-            next_node = next_node->next;
+        std::size_t done = 0;
+        try {
+          for (; done < count; ++done)
+            nodes[done] = allocator.allocate(1);
+        }
+        catch (...) {
+          deallocate_nodes(nodes, done);
+          throw;
+        }
+      }
+    }
 
-          next_node->next = ptr_new_node;
+    /**
+     * @brief Deallocate the nodes, the values are already destroyed.
+     * @param nodes [in] - pointers to the nodes.
+     * @param count [in] - number of the nodes.
+     */
+    void deallocate_nodes(node_t **nodes, std::size_t count) {
+      if constexpr (has_bulk_allocate<allocator_t>::value)
+        allocator.deallocate_bulk(nodes, count);
+      else
+        for (std::size_t i = 0; i < count; ++i)
+          allocator.deallocate(nodes[i], 1);
+    }
+
+    /**
+     * @brief Allocate the nodes for compact(), all or none.
+     * @param nodes [out] - pointers to the nodes.
+     * @param count [in] - number of the nodes.
+     */
+    void allocate_run(node_t **nodes, std::size_t count) {
+      if constexpr (has_fresh_allocate<allocator_t>::value)
+        allocator.allocate_fresh(nodes, count);
+      else
+        allocate_nodes(nodes, count);
+    }
+
+    /**
+     * @brief Destroy and deallocate the chain of the nodes in batches.
+     * @param first [in] - the first node of the chain, nullptr ends it.
+     */
+    void drop_chain(node_t *first) {
+      node_t *nodes[BULK_BATCH];
+      std::size_t count = 0;
+
+      while (first) {
+        node_t *next = first->next;
+        allocator.destroy(&first->value);
+        nodes[count++] = first;
+        if (count == BULK_BATCH) {
+          deallocate_nodes(nodes, count);
+          count = 0;
         }
+        first = next;
       }
+      deallocate_nodes(nodes, count);
+    }
+
+    /**
+     * @brief Add the nodes to the back of the list in batches.
+     * @tparam F - type of the constructor of the node.
+     * @param count [in] - number of the nodes.
+     * @param make [in] - constructs the node in the given memory.
+     */
+    template<typename F>
+    void append_bulk(std::size_t count, F make) {
+      node_t *nodes[BULK_BATCH];
+
+      while (count > 0) {
+        std::size_t batch = count < BULK_BATCH ? count : BULK_BATCH;
+        allocate_nodes(nodes, batch);
+
+        std::size_t built = 0;
+        try {
+          for (; built < batch; ++built)
+            make(nodes[built]);
+        }
+        catch (...) {
+          link_batch(nodes, built);
+          deallocate_nodes(nodes + built, batch - built);
+          throw;
+        }
+
+        link_batch(nodes, batch);
+        count -= batch;
+      }
+    }
+
+    /**
+     * @brief Add the copies of the range to the back of the list.
+     *
+     * The size of the forward range is known, so it is added in batches, the
+     * items of the input range are added one by one.
+     * @tparam InputIt - type of the iterator.
+     * @param first [in] - the beginning of the range.
+     * @param last [in] - the end of the range.
+     */
+    template<typename InputIt>
+    void append_range(InputIt first, InputIt last) {
+      using category_t =
+          typename std::iterator_traits<InputIt>::iterator_category;
+
+      if constexpr (std::is_base_of<std::forward_iterator_tag,
+                                    category_t>::value) {
+        append_bulk(static_cast<std::size_t>(std::distance(first, last)),
+                    [&](node_t *ptr) {
+                      allocator.construct(ptr, *first);
+                      ++first;
+                    });
+      }
+      else {
+        for (; first != last; ++first)
+          emplace_back(*first);
+      }
+    }
+
+    /**
+     * @brief Link the constructed nodes to the back of the list.
+     * @param nodes [in] - pointers to the nodes.
+     * @param count [in] - number of the nodes.
+     */
+    void link_batch(node_t **nodes, std::size_t count) {
+      if (count == 0)
+        return;
+
+      for (std::size_t i = 0; i + 1 < count; ++i)
+        nodes[i]->next = nodes[i + 1];
+      nodes[count - 1]->next = nullptr;
+      link_back(nodes[0], nodes[count - 1], count);
+    }
+
+    /**
+     * @brief Link the chain of the nodes to the back of the list.
+     * @param first [in] - the first node of the chain.
+     * @param last [in] - the last node of the chain.
+     * @param count [in] - number of the nodes in the chain.
+     */
+    void link_back(node_t *first, node_t *last, std::size_t count) {
+      if (tail_ == nullptr)
+        head_ = first;
+      else
+        tail_->next = first;
+      tail_ = last;
+      size_ += count;
+    }
+
+    /**
+     * @brief Move the values so that the i-th value of the chain is in the
+     *        i-th node by address, and link the nodes in this order.
+     * @param nodes [in/out] - the nodes in the list order, become sorted by
+     *                         address.
+     * @return the last node of the chain, its link is not set.
+     */
+    node_t * reorder(std::vector<node_t *> &nodes) {
+      const std::size_t count = nodes.size();
+      const std::size_t done = count;
+
+      /* the nodes by address with their positions in the list */
+      std::vector<std::pair<node_t *, std::size_t>> order(count);
+      for (std::size_t i = 0; i < count; ++i)
+        order[i] = std::make_pair(nodes[i], i);
+      std::sort(order.begin(), order.end(),
+                [](const std::pair<node_t *, std::size_t> &a,
+                   const std::pair<node_t *, std::size_t> &b) {
+                  return std::less<node_t *>()(a.first, b.first);
+                });
+
+      /* src[i] - the rank by address of the node whose value goes to the
+         i-th node by address */
+      std::vector<std::size_t> src(count);
+      for (std::size_t i = 0; i < count; ++i) {
+        nodes[i] = order[i].first;
+        src[order[i].second] = i;
+      }
+
+      for (std::size_t start = 0; start < count; ++start) {
+        if (src[start] == done || src[start] == start) {
+          src[start] = done;
+          continue;
+        }
+
+        T tmp(std::move(nodes[start]->value));
+        allocator.destroy(&nodes[start]->value);
+        std::size_t cur = start;
+        while (src[cur] != start) {
+          std::size_t from = src[cur];
+          allocator.construct(&nodes[cur]->value,
+                              std::move(nodes[from]->value));
+          allocator.destroy(&nodes[from]->value);
+          src[cur] = done;
+          cur = from;
+        }
+        allocator.construct(&nodes[cur]->value, std::move(tmp));
+        src[cur] = done;
+      }
+
+      for (std::size_t i = 0; i + 1 < count; ++i)
+        nodes[i]->next = nodes[i + 1];
+      return nodes[count - 1];
+    }
+
+    /**
+     * @brief The allocator for the move constructor.
+     * @param other [in] - the allocator of the moved list.
+     * @return the moved allocator or its copy if it can not be moved.
+     */
+    static allocator_t take_allocator(allocator_t &other) {
+      if constexpr (std::is_move_constructible<allocator_t>::value)
+        return std::move(other);
+      else
+        return allocator_t(static_cast<const allocator_t &>(other));
+    }
+
+    /**
+     * @brief Move the values of the other list into the new nodes at the back
+     *        of the list, the other list becomes empty.
+     * @param other [in] - the list to move.
+     */
+    void move_items(node_list &other) {
+      for (node_t *cur = other.head_; cur; cur = cur->next)
+        push_back(std::move(cur->value));
+      other.clear();
+    }
+
+    /**
+     * @brief Check that the nodes of the other list can be released by this
+     *        one.
+     * @param other [in] - the other list.
+     * @return true if the allocators are equal, otherwise false.
+     */
+    bool same_allocator(const node_list &other) const {
+      if constexpr (std::allocator_traits<allocator_t>::is_always_equal::value)
+        return true;
+      else if constexpr (has_allocator_equal<allocator_t>::value)
+        return allocator == other.allocator;
+      else
+        return false;
+    }
+
+    /**
+     * @brief Take the items of the other list as the chain of the nodes of
+     *        this list, the other list becomes empty.
+     *
+     * With the equal allocators the nodes are taken as is. The empty list
+     * takes them as is too: it swaps the allocators, so it gets the pool of
+     * the nodes and the other list gets the unused one. Otherwise the values
+     * are moved into the new nodes and the other list is cleared. If it
+     * throws, the new nodes are released and the other list keeps its items.
+     * @param other [in] - the list to take, must not be empty.
+     * @param first [out] - the first node of the chain.
+     * @param last [out] - the last node of the chain, its link is not set.
+     * @return number of the nodes in the chain.
+     */
+    std::size_t take_nodes(node_list &other, node_t *&first, node_t *&last) {
+      std::size_t count = other.size_;
+
+      bool relink = same_allocator(other);
+      if constexpr (std::is_move_constructible<allocator_t>::value &&
+                    std::is_move_assignable<allocator_t>::value) {
+        if (!relink && head_ == nullptr) {
+          std::swap(allocator, other.allocator);
+          relink = true;
+        }
+      }
+
+      if (relink) {
+        first = other.head_;
+        last = other.tail_;
+        other.release();
+        return count;
+      }
+
+      first = last = make_node(std::move(other.head_->value));
+      try {
+        for (node_t *cur = other.head_->next; cur; cur = cur->next) {
+          last->next = make_node(std::move(cur->value));
+          last = last->next;
+        }
+      }
+      catch (...) {
+        last->next = nullptr;
+        while (first) {
+          node_t *next = first->next;
+          drop_node(first);
+          first = next;
+        }
+        throw;
+      }
+      other.clear();
+      return count;
+    }
+
+    /**
+     * @brief Forget the nodes which are moved to the other list.
+     */
+    void release() {
+      head_ = nullptr;
+      tail_ = nullptr;
+      size_ = 0;
+    }
+
+    /**
+     * @brief Link the chain of the nodes after the given node.
+     * @param prev [in] - pointer to the node of the list.
+     * @param first [in] - the first node of the chain.
+     * @param last [in] - the last node of the chain.
+     * @param count [in] - number of the nodes in the chain.
+     */
+    void link_after(node_t *prev, node_t *first, node_t *last,
+                    std::size_t count) {
+      last->next = prev->next;
+      prev->next = first;
+      if (tail_ == prev)
+        tail_ = last;
+      size_ += count;
+    }
+
+    /**
+     * @brief The push_back helper function.
+     * @param ptr_new_node [in] - pointer to the new node.
+     */
+    void push_back_helper(node_t * const ptr_new_node) {
+      if (tail_ == nullptr)
+        head_ = ptr_new_node;
+      else
+        tail_->next = ptr_new_node;
+      tail_ = ptr_new_node;
       ++size_;
     }
 
@@ -327,6 +1177,8 @@ class node_list
     void push_front_helper(node_t *ptr_new_node) {
       ptr_new_node->next = head_;
       head_ = ptr_new_node;
+      if (tail_ == nullptr)
+        tail_ = ptr_new_node;
       ++size_;
     }
 };
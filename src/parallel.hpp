@@ -0,0 +1,382 @@
+/**
+ ******************************************************************************
+ * @file    parallel.hpp
+ * @author  Maxim <aveter@bk.ru>
+ * @date    02/06/2019
+ * @brief   Description of the parallel algorithms over the lists.
+ ******************************************************************************
+ */
+
+#ifndef PARALLEL_HPP_
+#define PARALLEL_HPP_
+
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+
+/**
+ * Discription of the "Thread Pool" class.
+ *
+ * The fixed number of the workers take the tasks from the common queue.
+ * The task that waits for the other tasks of the same pool may never be
+ * scheduled, so the parallel algorithms run inline when they are called from
+ * the worker, see is_worker().
+ */
+class thread_pool
+{
+  public:
+    /**
+     * @brief Constructor.
+     * @param threads [in] - number of the workers. Default on the number of
+     *                       the hardware threads.
+     */
+    explicit thread_pool(std::size_t threads = std::thread::hardware_concurrency()) {
+      if (threads == 0)
+        threads = 1;
+
+      for (std::size_t i = 0; i < threads; ++i)
+        workers_.emplace_back([this] { work(); });
+    }
+
+    /**
+     * Virtual distructor, waits for the queued tasks.
+     */
+    virtual ~thread_pool() {
+      {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stop_ = true;
+      }
+      cond_.notify_all();
+
+      for (std::thread &worker: workers_)
+        worker.join();
+    }
+
+    thread_pool(const thread_pool &) = delete;
+    thread_pool & operator=(const thread_pool &) = delete;
+
+    /**
+     * @brief Number of the workers.
+     * @return number of the workers.
+     */
+    std::size_t size() const {
+      return workers_.size();
+    }
+
+    /**
+     * @brief Check that the calling thread is the worker of the pool.
+     * @return true if the thread is the worker, otherwise false.
+     */
+    bool is_worker() const {
+      return current_pool() == this;
+    }
+
+    /**
+     * @brief Queue the task.
+     * @tparam F - type of the task.
+     * @param task [in] - the task.
+     * @return future of the task result.
+     */
+    template<typename F>
+    std::future<decltype(std::declval<F &>()())> submit(F task) {
+      using result_t = decltype(task());
+
+      auto job = std::make_shared<std::packaged_task<result_t()>>(std::move(task));
+      std::future<result_t> res = job->get_future();
+      {
+        std::lock_guard<std::mutex> lock(mutex_);
+        tasks_.emplace([job] { (*job)(); });
+      }
+      cond_.notify_one();
+      return res;
+    }
+
+
+  private:
+    std::vector<std::thread> workers_;          /**< - the workers. */
+    std::queue<std::function<void()>> tasks_;   /**< - the queued tasks. */
+    std::mutex mutex_;                          /**< - guard of the queue. */
+    std::condition_variable cond_;              /**< - new task or stop. */
+    bool stop_ = false;                         /**< - the pool is stopped. */
+
+    /**
+     * @brief The pool of the calling thread.
+     * @return reference to the pointer to the pool, nullptr if the thread is
+     *         not the worker.
+     */
+    static const thread_pool *& current_pool() {
+      thread_local const thread_pool *pool = nullptr;
+      return pool;
+    }
+
+    /**
+     * @brief The loop of the worker.
+     */
+    void work() {
+      current_pool() = this;
+      for (;;) {
+        std::function<void()> task;
+        {
+          std::unique_lock<std::mutex> lock(mutex_);
+          cond_.wait(lock, [this] { return stop_ || !tasks_.empty(); });
+          if (tasks_.empty())
+            return;
+
+          task = std::move(tasks_.front());
+          tasks_.pop();
+        }
+        task();
+      }
+    }
+};
+
+
+/**
+ * Discription of the segments of the list.
+ *
+ * The list is walked once to find the split points, then the segments can be
+ * processed in parallel. The segments stay valid while the list is not
+ * changed, so they can be cached and reused for several algorithms.
+ * @tparam Iter - the type of the list iterator.
+ */
+template<typename Iter>
+class list_segments
+{
+  public:
+    /**
+     * @brief Constructor, splits the list into the segments of equal size.
+     * @tparam L - the type of the list.
+     * @param list [in] - the list.
+     * @param parts [in] - the required number of the segments.
+     */
+    template<typename L>
+    list_segments(L &list, std::size_t parts) {
+      std::size_t size = list.size();
+      if (parts > size)
+        parts = size;
+
+      Iter it = list.begin();
+      for (std::size_t i = 0; i < parts; ++i) {
+        std::size_t len = size / parts + (i < size % parts ? 1 : 0);
+        firsts_.push_back(it);
+        lengths_.push_back(len);
+        for (std::size_t j = 0; j < len; ++j)
+          ++it;
+      }
+    }
+
+    /**
+     * @brief Number of the segments.
+     * @return number of the segments.
+     */
+    std::size_t count() const {
+      return firsts_.size();
+    }
+
+    /**
+     * @brief The first item of the segment.
+     * @param idx [in] - index of the segment.
+     * @return iterator to the first item.
+     */
+    Iter first(std::size_t idx) const {
+      return firsts_[idx];
+    }
+
+    /**
+     * @brief Number of the items in the segment.
+     * @param idx [in] - index of the segment.
+     * @return number of the items.
+     */
+    std::size_t length(std::size_t idx) const {
+      return lengths_[idx];
+    }
+
+
+  private:
+    std::vector<Iter> firsts_;          /**< - first items of the segments. */
+    std::vector<std::size_t> lengths_;  /**< - sizes of the segments. */
+};
+
+
+/**
+ * @brief Split the list into the segments, one for every worker of the pool
+ *        and one for the calling thread.
+ * @tparam L - the type of the list.
+ * @param pool [in] - the pool of the workers.
+ * @param list [in] - the list.
+ * @return the segments.
+ */
+template<typename L>
+list_segments<decltype(std::declval<L &>().begin())>
+make_segments(const thread_pool &pool, L &list)
+{
+  return list_segments<decltype(list.begin())>(list, pool.size() + 1);
+}
+
+
+/**
+ * @brief Apply the reduction to the segments in parallel.
+ *
+ * The last segment is processed by the calling thread. The partial results
+ * are combined in the order of the segments. Called from the worker of the
+ * pool, all the segments are processed by the calling thread.
+ * @tparam Iter - the type of the list iterator.
+ * @tparam R - the type of the result.
+ * @tparam Reduce - the type of the binary operation.
+ * @tparam Transform - the type of the unary operation.
+ * @param pool [in] - the pool of the workers.
+ * @param seg [in] - the segments of the list.
+ * @param init [in] - the initial value.
+ * @param reduce [in] - the binary operation, must be associative.
+ * @param transform [in] - the unary operation applied to every item.
+ * @return the result of the reduction.
+ */
+template<typename Iter, typename R, typename Reduce, typename Transform>
+R parallel_transform_reduce(thread_pool &pool, const list_segments<Iter> &seg,
+                            R init, Reduce reduce, Transform transform)
+{
+  auto run = [&seg, &reduce, &transform](std::size_t idx) {
+    Iter it = seg.first(idx);
+    R part = transform(*it);
+    for (std::size_t i = 1; i < seg.length(idx); ++i)
+      part = reduce(std::move(part), transform(*++it));
+    return part;
+  };
+
+  if (seg.count() == 0)
+    return init;
+
+  if (pool.is_worker()) {
+    for (std::size_t idx = 0; idx < seg.count(); ++idx)
+      init = reduce(std::move(init), run(idx));
+    return init;
+  }
+
+  std::vector<std::future<R>> parts;
+
+  /* The tasks refer to the local data, so they are waited on exception too */
+  struct waiter {
+    std::vector<std::future<R>> &parts;
+    ~waiter() {
+      for (std::future<R> &part: parts)
+        if (part.valid())
+          part.wait();
+    }
+  } guard{parts};
+
+  for (std::size_t idx = 0; idx + 1 < seg.count(); ++idx)
+    parts.push_back(pool.submit([&run, idx] { return run(idx); }));
+
+  R last = run(seg.count() - 1);
+  for (std::future<R> &part: parts)
+    init = reduce(std::move(init), part.get());
+  return reduce(std::move(init), std::move(last));
+}
+
+
+/**
+ * @brief Apply the reduction to the list in parallel.
+ * @tparam L - the type of the list.
+ * @tparam R - the type of the result.
+ * @tparam Reduce - the type of the binary operation.
+ * @tparam Transform - the type of the unary operation.
+ * @param pool [in] - the pool of the workers.
+ * @param list [in] - the list.
+ * @param init [in] - the initial value.
+ * @param reduce [in] - the binary operation, must be associative.
+ * @param transform [in] - the unary operation applied to every item.
+ * @return the result of the reduction.
+ */
+template<typename L, typename R, typename Reduce, typename Transform,
+         typename = decltype(std::declval<L &>().size())>
+R parallel_transform_reduce(thread_pool &pool, L &list, R init, Reduce reduce,
+                            Transform transform)
+{
+  return parallel_transform_reduce(pool, make_segments(pool, list),
+                                   std::move(init), reduce, transform);
+}
+
+
+/**
+ * @brief Apply the function to every item of the segments in parallel.
+ * @tparam Iter - the type of the list iterator.
+ * @tparam F - the type of the function.
+ * @param pool [in] - the pool of the workers.
+ * @param seg [in] - the segments of the list.
+ * @param f [in] - the function.
+ */
+template<typename Iter, typename F>
+void parallel_for_each(thread_pool &pool, const list_segments<Iter> &seg, F f)
+{
+  parallel_transform_reduce(pool, seg, 0,
+                            [](int, int) { return 0; },
+                            [&f](decltype(*std::declval<Iter>()) val) {
+                              f(val);
+                              return 0;
+                            });
+}
+
+
+/**
+ * @brief Apply the function to every item of the list in parallel.
+ * @tparam L - the type of the list.
+ * @tparam F - the type of the function.
+ * @param pool [in] - the pool of the workers.
+ * @param list [in] - the list.
+ * @param f [in] - the function.
+ */
+template<typename L, typename F,
+         typename = decltype(std::declval<L &>().size())>
+void parallel_for_each(thread_pool &pool, L &list, F f)
+{
+  parallel_for_each(pool, make_segments(pool, list), f);
+}
+
+
+/**
+ * @brief Count the items of the segments which satisfy the predicate.
+ * @tparam Iter - the type of the list iterator.
+ * @tparam P - the type of the predicate.
+ * @param pool [in] - the pool of the workers.
+ * @param seg [in] - the segments of the list.
+ * @param pred [in] - the predicate.
+ * @return number of the items.
+ */
+template<typename Iter, typename P>
+std::size_t parallel_count_if(thread_pool &pool, const list_segments<Iter> &seg,
+                              P pred)
+{
+  return parallel_transform_reduce(pool, seg, std::size_t(0),
+                                   std::plus<std::size_t>(),
+                                   [&pred](decltype(*std::declval<Iter>()) val) {
+                                     return std::size_t(pred(val) ? 1 : 0);
+                                   });
+}
+
+
+/**
+ * @brief Count the items of the list which satisfy the predicate.
+ * @tparam L - the type of the list.
+ * @tparam P - the type of the predicate.
+ * @param pool [in] - the pool of the workers.
+ * @param list [in] - the list.
+ * @param pred [in] - the predicate.
+ * @return number of the items.
+ */
+template<typename L, typename P,
+         typename = decltype(std::declval<L &>().size())>
+std::size_t parallel_count_if(thread_pool &pool, L &list, P pred)
+{
+  return parallel_count_if(pool, make_segments(pool, list), pred);
+}
+
+#endif /* PARALLEL_HPP_ */
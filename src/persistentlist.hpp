@@ -0,0 +1,519 @@
+/**
+ ******************************************************************************
+ * @file    persistentlist.hpp
+ * @author  Maxim <aveter@bk.ru>
+ * @date    12/06/2019
+ * @brief   Description of the persistent snapshots of the lists.
+ *
+ * The list of trivially copyable values is saved to the file with the links
+ * stored as the offsets from the beginning of the file, so the file can be
+ * mapped at any address and walked at once, without the allocation and the
+ * construction of the nodes.
+ ******************************************************************************
+ */
+
+#ifndef PERSISTENTLIST_HPP_
+#define PERSISTENTLIST_HPP_
+
+#include "nodelist.hpp"
+
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <type_traits>
+#include <utility>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+
+/** Version of the format of the snapshot. */
+const std::uint32_t SNAPSHOT_VERSION = 1;
+
+/** Signature of the snapshot file. */
+const char SNAPSHOT_MAGIC[8] = {'N', 'O', 'D', 'E', 'L', 'S', 'T', '\0'};
+
+
+/**
+ * Discription of the header of the snapshot file.
+ */
+struct snapshot_header
+{
+  char magic[8];              /**< - signature of the file. */
+  std::uint32_t version;      /**< - version of the format. */
+  std::uint32_t value_size;   /**< - size of the value. */
+  std::uint32_t value_align;  /**< - alignment of the value. */
+  std::uint32_t node_size;    /**< - size of the node. */
+  std::uint64_t size;         /**< - number of the values. */
+  std::uint64_t head;         /**< - offset of the first node, 0 - none. */
+  std::uint64_t tail;         /**< - offset of the last node, 0 - none. */
+};
+
+
+/**
+ * Discription of the node of the snapshot.
+ *
+ * @tparam T - the type of the value, trivially copyable.
+ */
+template<typename T>
+struct snapshot_node
+{
+  std::uint64_t next;   /**< - offset of the next node, 0 - the last one. */
+  alignas(T) unsigned char value[sizeof(T)];  /**< - the value */
+};
+
+
+/**
+ * @brief Offset of the first node in the file.
+ * @tparam T - the type of the value.
+ * @return offset aligned for the node.
+ */
+template<typename T>
+constexpr std::size_t snapshot_nodes_offset()
+{
+  return (sizeof(snapshot_header) + alignof(snapshot_node<T>) - 1) /
+         alignof(snapshot_node<T>) * alignof(snapshot_node<T>);
+}
+
+
+/**
+ * @brief Save the list to the file.
+ *
+ * The nodes are written in the order of the list, so the snapshot is compact
+ * whatever the placement of the nodes in the memory.
+ * @tparam L - the type of the list: node_list, unrolled_list ...
+ * @param list [in] - the list.
+ * @param path [in] - path to the file, it is overwritten.
+ */
+template<typename L>
+void save_snapshot(const L &list, const std::string &path)
+{
+  using value_t = typename std::decay<decltype(*list.begin())>::type;
+  using node_t = snapshot_node<value_t>;
+  static_assert(std::is_trivially_copyable<value_t>::value,
+                "The snapshot keeps only the trivially copyable values");
+
+  const std::size_t first = snapshot_nodes_offset<value_t>();
+  const std::uint64_t count = list.size();
+
+  snapshot_header header;
+  std::memset(&header, 0, sizeof(header));
+  std::memcpy(header.magic, SNAPSHOT_MAGIC, sizeof(header.magic));
+  header.version = SNAPSHOT_VERSION;
+  header.value_size = sizeof(value_t);
+  header.value_align = alignof(value_t);
+  header.node_size = sizeof(node_t);
+  header.size = count;
+  header.head = count ? first : 0;
+  header.tail = count ? first + (count - 1) * sizeof(node_t) : 0;
+
+  std::ofstream out(path, std::ios::binary | std::ios::trunc);
+  if (!out)
+    throw std::runtime_error("Can not create the snapshot: " + path);
+
+  char pad[alignof(node_t) > 1 ? alignof(node_t) : 1] = {};
+  out.write(reinterpret_cast<const char *>(&header), sizeof(header));
+  out.write(pad, static_cast<std::streamsize>(first - sizeof(header)));
+
+  std::uint64_t idx = 0;
+  for (const value_t &val: list) {
+    node_t node;
+    std::memset(&node, 0, sizeof(node));
+    node.next = ++idx < count ? first + idx * sizeof(node_t) : 0;
+    std::memcpy(node.value, &val, sizeof(value_t));
+    out.write(reinterpret_cast<const char *>(&node), sizeof(node));
+  }
+
+  if (!out.flush())
+    throw std::runtime_error("Can not write the snapshot: " + path);
+}
+
+
+/**
+ * Discription of an iterator of the mapped list.
+ *
+ * @tparam T - the type of the value.
+ * @tparam V - the type of the access to the value: const T for the constant
+ *             iterator, T for the mutable one. Default on const T.
+ */
+template<typename T, typename V = const T>
+class snapshot_iterator
+{
+  public:
+    /* Aliases */
+    using iterator_category = std::forward_iterator_tag;
+    using value_type = T;
+    using difference_type = std::ptrdiff_t;
+    using pointer = V *;
+    using reference = V &;
+
+    /**
+     * @brief Constructor with param.
+     * @param base [in] - the beginning of the mapping.
+     * @param offset [in] - offset of the node, 0 - the end.
+     */
+    snapshot_iterator(unsigned char *base = nullptr, std::uint64_t offset = 0)
+      : base_(base), offset_(offset)
+    {}
+
+    /**
+     * @brief Conversion of the mutable iterator to the constant one.
+     * @param other [in] - mutable iterator.
+     */
+    template<typename U, typename = typename std::enable_if<
+                           std::is_same<U, T>::value &&
+                           std::is_const<V>::value>::type>
+    snapshot_iterator(const snapshot_iterator<U, U> &other)
+      : base_(other.base_), offset_(other.offset_)
+    {}
+
+    /**
+     * @brief Inequality operator.
+     * @param  other [in] - iterator.
+     * @return true if the iterators are not equal and false otherwise.
+     */
+    bool operator!=(const snapshot_iterator &other) const {
+      return offset_ != other.offset_;
+    }
+
+    /**
+     * @brief Comparison operator.
+     * @param other [in] - iterator
+     * @return true if equal and false otherwise.
+     */
+    bool operator==(const snapshot_iterator &other) const {
+      return offset_ == other.offset_;
+    }
+
+    /**
+     * @brief Dereference operator.
+     * @return reference on the data.
+     */
+    V & operator*() const {
+      return *reinterpret_cast<V *>(node()->value);
+    }
+
+    /**
+     * @brief Pointer selector operator.
+     * @return pointer on the data.
+     */
+    V * operator->() const {
+      return &**this;
+    }
+
+    /**
+     * @brief Increment operator, follows the offset of the next node.
+     * @return increment data.
+     */
+    snapshot_iterator & operator++() {
+      if (offset_)
+        offset_ = node()->next;
+      return *this;
+    }
+
+    /**
+     * @brief Postfix increment operator.
+     * @return the iterator before the increment.
+     */
+    snapshot_iterator operator++(int) {
+      snapshot_iterator tmp(*this);
+      ++(*this);
+      return tmp;
+    }
+
+
+  private:
+    unsigned char *base_;     /**< - the beginning of the mapping. */
+    std::uint64_t offset_;    /**< - offset of the current node. */
+
+    /* Friends */
+    template<typename, typename>
+    friend class snapshot_iterator;
+
+    /**
+     * @brief The current node.
+     * @return pointer to the node.
+     */
+    snapshot_node<T> * node() const {
+      return reinterpret_cast<snapshot_node<T> *>(base_ + offset_);
+    }
+};
+
+
+/**
+ * Discription of the list mapped from the snapshot file.
+ *
+ * The file is mapped private: the nodes are not allocated and the values
+ * are not copied. The values can be changed in place, the changed pages are
+ * copied on write and the file is kept as it is. to_list() copies the values
+ * into node_list to change the links.
+ *
+ * The opening checks the header and that the nodes fit the file, it is O(1)
+ * and does not touch the nodes. The links are trusted unless the full check
+ * is asked: the chain of the nodes is walked once, every link is checked
+ * against the size of the file and the alignment of the node, so the damaged
+ * file is rejected instead of being read out of the mapping. The full check
+ * is O(n) and loads all the pages of the file.
+ * @tparam T - the type of the value, the same as on saving.
+ */
+template<typename T>
+class mapped_list
+{
+  static_assert(std::is_trivially_copyable<T>::value,
+                "The snapshot keeps only the trivially copyable values");
+
+  public:
+    /* Aliases */
+    using iterator_t = snapshot_iterator<T, T>;
+    using const_iterator_t = snapshot_iterator<T, const T>;
+
+    /**
+     * @brief Open the snapshot.
+     *
+     * std::system_error is thrown if the file can not be mapped and
+     * std::runtime_error if it is not the snapshot of T or its links are
+     * damaged.
+     * @param path [in] - path to the file.
+     * @param check_links [in] - walk the chain of the nodes, for the file
+     *                           from the untrusted source. Default false.
+     */
+    explicit mapped_list(const std::string &path, bool check_links = false) {
+      int fd = ::open(path.c_str(), O_RDONLY);
+      if (fd < 0)
+        throw std::system_error(errno, std::generic_category(), path);
+
+      struct stat st;
+      if (::fstat(fd, &st) != 0) {
+        int err = errno;
+        ::close(fd);
+        throw std::system_error(err, std::generic_category(), path);
+      }
+
+      length_ = static_cast<std::size_t>(st.st_size);
+      void *ptr = length_ ? ::mmap(nullptr, length_, PROT_READ | PROT_WRITE,
+                                   MAP_PRIVATE, fd, 0)
+                          : MAP_FAILED;
+      int err = errno;
+      ::close(fd);
+      if (ptr == MAP_FAILED)
+        throw std::system_error(length_ ? err : EINVAL,
+                                std::generic_category(), path);
+
+      base_ = static_cast<unsigned char *>(ptr);
+      if (!is_valid_header() || (check_links && !is_valid_chain())) {
+        ::munmap(base_, length_);
+        throw std::runtime_error("Invalid snapshot: " + path);
+      }
+    }
+
+    /**
+     * Virtual distructor, unmaps the file.
+     */
+    virtual ~mapped_list() {
+      if (base_)
+        ::munmap(base_, length_);
+    }
+
+    /**
+     * @brief Move constructor.
+     * @param other [in] - the object to move.
+     */
+    mapped_list(mapped_list &&other)
+      : base_(other.base_), length_(other.length_) {
+      other.base_ = nullptr;
+      other.length_ = 0;
+    }
+
+    /**
+     * @brief Move operator.
+     * @param other [in] - the object to move.
+     */
+    mapped_list & operator=(mapped_list &&other) {
+      std::swap(base_, other.base_);
+      std::swap(length_, other.length_);
+      return *this;
+    }
+
+    mapped_list(const mapped_list &) = delete;
+    mapped_list & operator=(const mapped_list &) = delete;
+
+    /**
+     * @brief  The begin iterator of the list.
+     * @return Returns an iterator to the beginning of the list.
+     */
+    iterator_t begin() {
+      return iterator_t(base_, header().head);
+    }
+
+    /**
+     * @brief  The end iterator of the list.
+     * @return Returns an iterator to the end of the list.
+     */
+    iterator_t end() {
+      return iterator_t(base_, 0);
+    }
+
+    /**
+     * @brief  The begin iterator of the constant list.
+     * @return Returns an const iterator to the beginning of the list.
+     */
+    const_iterator_t begin() const {
+      return const_iterator_t(base_, header().head);
+    }
+
+    /**
+     * @brief  The end iterator of the constant list.
+     * @return Returns an const iterator to the end of the list.
+     */
+    const_iterator_t end() const {
+      return const_iterator_t(base_, 0);
+    }
+
+    /**
+     * @brief The number of data in the list.
+     * @return The number of data.
+     */
+    std::size_t size() const {
+      return static_cast<std::size_t>(header().size);
+    }
+
+    /**
+     * @brief Check that the list has no data.
+     * @return true if the list is empty, otherwise false.
+     */
+    bool empty() const {
+      return header().size == 0;
+    }
+
+    /**
+     * @brief The first item of the list, the list must not be empty.
+     * @return reference to the data.
+     */
+    T & front() {
+      return *begin();
+    }
+
+    /**
+     * @brief The first item of the constant list, the list must not be empty.
+     * @return reference to the data.
+     */
+    const T & front() const {
+      return *begin();
+    }
+
+    /**
+     * @brief The last item of the list, the list must not be empty.
+     * @return reference to the data.
+     */
+    T & back() {
+      return *iterator_t(base_, header().tail);
+    }
+
+    /**
+     * @brief The last item of the constant list, the list must not be empty.
+     * @return reference to the data.
+     */
+    const T & back() const {
+      return *const_iterator_t(base_, header().tail);
+    }
+
+    /**
+     * @brief Copy the values into the list which can be changed.
+     * @tparam A - allocator of the list. Default on std::allocator.
+     * @param alloc [in] - allocator of the list.
+     * @return the list with the values in the same order.
+     */
+    template<typename A = std::allocator<node<T>>>
+    node_list<T, A> to_list(const A &alloc = A()) const {
+      return node_list<T, A>(begin(), end(), alloc);
+    }
+
+
+  private:
+    unsigned char *base_ = nullptr;   /**< - the mapped file. */
+    std::size_t length_ = 0;          /**< - size of the mapping. */
+
+    /**
+     * @brief The header of the file.
+     * @return reference to the header.
+     */
+    const snapshot_header & header() const {
+      return *reinterpret_cast<const snapshot_header *>(base_);
+    }
+
+    /**
+     * @brief Check the offset of the node.
+     * @param offset [in] - offset from the beginning of the file.
+     * @return true if the node is inside the file and aligned, otherwise
+     *         false.
+     */
+    bool is_valid_node(std::uint64_t offset) const {
+      const std::uint64_t first = snapshot_nodes_offset<T>();
+      const std::uint64_t node = sizeof(snapshot_node<T>);
+
+      return offset >= first && (offset - first) % node == 0 &&
+             offset <= length_ && length_ - offset >= node;
+    }
+
+    /**
+     * @brief Walk the chain of the nodes.
+     *
+     * The chain must have exactly size() nodes, each one is inside the file,
+     * the last one is the tail. So the iterators never leave the mapping and
+     * never loop.
+     * @return true if the chain is valid, otherwise false.
+     */
+    bool is_valid_chain() const {
+      const snapshot_header &hdr = header();
+      std::uint64_t offset = hdr.head;
+
+      for (std::uint64_t i = 0; i < hdr.size; ++i) {
+        if (!is_valid_node(offset))
+          return false;
+
+        const snapshot_node<T> *cur =
+            reinterpret_cast<const snapshot_node<T> *>(base_ + offset);
+        if (i + 1 == hdr.size)
+          return offset == hdr.tail && cur->next == 0;
+        offset = cur->next;
+      }
+      return true;
+    }
+
+    /**
+     * @brief Check the header of the file.
+     * @return true if the header is of the snapshot of T, otherwise false.
+     */
+    bool is_valid_header() const {
+      if (length_ < sizeof(snapshot_header))
+        return false;
+
+      const snapshot_header &hdr = header();
+      const std::uint64_t first = snapshot_nodes_offset<T>();
+      const std::uint64_t node = sizeof(snapshot_node<T>);
+
+      return std::memcmp(hdr.magic, SNAPSHOT_MAGIC, sizeof(hdr.magic)) == 0 &&
+             hdr.version == SNAPSHOT_VERSION &&
+             hdr.value_size == sizeof(T) && hdr.value_align == alignof(T) &&
+             hdr.node_size == node &&
+             hdr.size <= (length_ - sizeof(snapshot_header)) / node &&
+             first + hdr.size * node <= length_ &&
+             (hdr.size == 0 ? hdr.head == 0 && hdr.tail == 0
+                            : hdr.head >= first && hdr.tail >= first &&
+                              (hdr.head - first) % node == 0 &&
+                              (hdr.tail - first) % node == 0 &&
+                              hdr.head + node <= length_ &&
+                              hdr.tail + node <= length_);
+    }
+};
+
+#endif /* PERSISTENTLIST_HPP_ */
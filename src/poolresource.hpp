@@ -0,0 +1,109 @@
+/**
+ ******************************************************************************
+ * @file    poolresource.hpp
+ * @author  Maxim <aveter@bk.ru>
+ * @date    18/06/2019
+ * @brief   Description of the template "Pool Resource".
+ ******************************************************************************
+ */
+
+#ifndef POOLRESOURCE_HPP_
+#define POOLRESOURCE_HPP_
+
+#include "arenaallocator.hpp"
+
+#include <cstddef>
+#include <memory_resource>
+
+
+/**
+ * Discription of the "Pool Resource" class.
+ *
+ * The memory resource of the std::pmr containers over the arena of the size
+ * classes. The pool is chosen at run time, so the containers of any types
+ * (std::pmr::map, std::pmr::list, node_list with
+ * std::pmr::polymorphic_allocator ...) can share one pre-sized resource
+ * without the separate instantiation for every pool.
+ *
+ * The over-aligned requests go to the upstream resource. The resource is not
+ * thread-safe, as std::pmr::unsynchronized_pool_resource.
+ * @tparam ARENA - type of the arena. Default on fixed_arena<1024>.
+ */
+template<typename ARENA = fixed_arena<1024>>
+class pool_resource : public std::pmr::memory_resource
+{
+  public:
+    /**
+     * @brief Constructor.
+     * @param upstream [in] - resource of the over-aligned requests. Default
+     *                        on the default resource.
+     */
+    explicit pool_resource(std::pmr::memory_resource *upstream =
+                             std::pmr::get_default_resource())
+      : upstream_(upstream)
+    {}
+
+    pool_resource(const pool_resource &) = delete;
+    pool_resource & operator=(const pool_resource &) = delete;
+
+    /**
+     * @brief The arena of the resource.
+     * @return reference to the arena.
+     */
+    const ARENA & arena() const {
+      return arena_;
+    }
+
+    /**
+     * @brief The resource of the over-aligned requests.
+     * @return pointer to the resource.
+     */
+    std::pmr::memory_resource * upstream_resource() const {
+      return upstream_;
+    }
+
+
+  protected:
+    /**
+     * @brief Allocate memory.
+     * @param bytes [in] - number of bytes.
+     * @param align [in] - alignment of the memory.
+     * @return pointer to the allocated memory.
+     */
+    void * do_allocate(std::size_t bytes, std::size_t align) override {
+      if (align > alignof(std::max_align_t))
+        return upstream_->allocate(bytes, align);
+      return arena_.alloc(bytes);
+    }
+
+    /**
+     * @brief Deallocate memory.
+     * @param ptr [in] - pointer to the memory.
+     * @param bytes [in] - number of bytes.
+     * @param align [in] - alignment of the memory.
+     */
+    void do_deallocate(void *ptr, std::size_t bytes,
+                       std::size_t align) override {
+      if (align > alignof(std::max_align_t))
+        upstream_->deallocate(ptr, bytes, align);
+      else
+        arena_.dealloc(ptr, bytes);
+    }
+
+    /**
+     * @brief Equality of the resources.
+     * @param other [in] - the resource.
+     * @return true if it is the same object: the memory belongs to the arena.
+     */
+    bool do_is_equal(const std::pmr::memory_resource &other)
+        const noexcept override {
+      return this == &other;
+    }
+
+
+  private:
+    ARENA arena_;                           /**< - the size classes. */
+    std::pmr::memory_resource *upstream_;   /**< - over-aligned requests. */
+};
+
+#endif /* POOLRESOURCE_HPP_ */
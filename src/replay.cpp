@@ -0,0 +1,415 @@
+/**
+ ******************************************************************************
+ * @file    replay.cpp
+ * @author  Maxim <aveter@bk.ru>
+ * @date    29/06/2019
+ * @brief   Replay of the trace of the allocations with the configurations of
+ *          "Fixed Allocator".
+ ******************************************************************************
+ */
+
+#include "alloctrace.hpp"
+#include "fixedallocator.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <new>
+#include <string>
+#include <utility>
+#include <vector>
+
+
+/** The object sizes of the replay, the larger requests are skipped. */
+const std::size_t REPLAY_SIZES[] = {8, 16, 32, 64, 128, 256, 512};
+
+
+/**
+ * The object of the given size.
+ */
+template<std::size_t SIZE>
+struct replay_cell
+{
+  alignas(SIZE < alignof(std::max_align_t) ? SIZE : alignof(std::max_align_t))
+  unsigned char bytes[SIZE];
+};
+
+
+/**
+ * The operation of the replay.
+ */
+struct replay_op
+{
+  std::uint32_t target;   /**< - the allocator of the replay. */
+  std::uint32_t slot;     /**< - the slot of the pointer. */
+  std::uint32_t count;    /**< - number of the objects. */
+  bool alloc;             /**< - allocation or release. */
+};
+
+
+/**
+ * The trace prepared for the replay: the addresses are replaced with the
+ * slots, every allocator of the trace and the object size has its target.
+ */
+struct replay_program
+{
+  std::vector<std::size_t> cells;   /**< - the object size of the target. */
+  std::vector<replay_op> ops;       /**< - the operations. */
+  std::size_t slots = 0;            /**< - number of the slots. */
+  std::size_t skipped = 0;          /**< - events which are not replayed. */
+};
+
+
+/**
+ * The result of the replay.
+ */
+struct replay_result
+{
+  double seconds = 0;           /**< - time of the replay. */
+  std::size_t failures = 0;     /**< - allocations thrown std::bad_alloc. */
+  std::size_t fallbacks = 0;    /**< - requests served by the system heap. */
+  std::size_t peak_bytes = 0;   /**< - maximum of the memory in use. */
+};
+
+
+/**
+ * Discription of the allocator of the replay.
+ */
+class replay_target
+{
+  public:
+    virtual ~replay_target() = default;
+
+    /**
+     * @brief Allocate the objects.
+     * @param count [in] - number of the objects.
+     * @return pointer to the memory.
+     */
+    virtual void * alloc(std::size_t count) = 0;
+
+    /**
+     * @brief Release the objects.
+     * @param ptr [in] - pointer to the memory.
+     * @param count [in] - number of the objects.
+     */
+    virtual void free(void *ptr, std::size_t count) = 0;
+
+    /**
+     * @brief Number of the requests served by the system heap.
+     * @return number of the requests.
+     */
+    virtual std::size_t fallbacks() const = 0;
+
+    /**
+     * @brief Memory reserved for the single objects.
+     * @return number of the bytes.
+     */
+    virtual std::size_t reserved() const = 0;
+};
+
+
+/**
+ * @brief Heap requests of std::allocator, all of them.
+ */
+template<typename T>
+std::size_t fallbacks_of(const std::allocator<T> &)
+{
+  return 0;
+}
+
+/**
+ * @brief Heap requests of "Fixed Allocator".
+ */
+template<typename T, std::size_t E, typename G, typename B, std::size_t S>
+std::size_t fallbacks_of(const fixed_allocator<T, E, G, B, S> &alloc)
+{
+  return alloc.fallback_count();
+}
+
+/**
+ * @brief Reserved memory of std::allocator, nothing is reserved.
+ */
+template<typename T>
+std::size_t reserved_of(const std::allocator<T> &)
+{
+  return 0;
+}
+
+/**
+ * @brief Reserved memory of "Fixed Allocator", the buffer of single objects.
+ */
+template<typename T, std::size_t E, typename G, typename B, std::size_t S>
+std::size_t reserved_of(const fixed_allocator<T, E, G, B, S> &alloc)
+{
+  return alloc.stats().capacity * sizeof(T);
+}
+
+
+/**
+ * The allocator of the replay over the allocator of the cells.
+ *
+ * @tparam A - the allocator.
+ */
+template<typename A>
+class replay_target_impl : public replay_target
+{
+  public:
+    using value_type = typename A::value_type;
+
+    void * alloc(std::size_t count) override {
+      return alloc_.allocate(count);
+    }
+
+    void free(void *ptr, std::size_t count) override {
+      alloc_.deallocate(static_cast<value_type *>(ptr), count);
+    }
+
+    std::size_t fallbacks() const override {
+      return fallbacks_of(alloc_);
+    }
+
+    std::size_t reserved() const override {
+      return reserved_of(alloc_);
+    }
+
+
+  private:
+    A alloc_;   /**< - the allocator */
+};
+
+
+/**
+ * @brief Make the allocator of the replay for the object size.
+ * @tparam A - the configuration, the allocator of the type.
+ * @param cell [in] - the object size, one of REPLAY_SIZES.
+ * @return the allocator.
+ */
+template<template<typename> class A>
+std::unique_ptr<replay_target> make_target(std::size_t cell)
+{
+  switch (cell) {
+    case 8: return std::make_unique<replay_target_impl<A<replay_cell<8>>>>();
+    case 16: return std::make_unique<replay_target_impl<A<replay_cell<16>>>>();
+    case 32: return std::make_unique<replay_target_impl<A<replay_cell<32>>>>();
+    case 64: return std::make_unique<replay_target_impl<A<replay_cell<64>>>>();
+    case 128:
+      return std::make_unique<replay_target_impl<A<replay_cell<128>>>>();
+    case 256:
+      return std::make_unique<replay_target_impl<A<replay_cell<256>>>>();
+    default:
+      return std::make_unique<replay_target_impl<A<replay_cell<512>>>>();
+  }
+}
+
+
+/* Configurations of the replay */
+template<typename T>
+using std_config = std::allocator<T>;
+template<typename T>
+using fixed_256_config = fixed_allocator<T, 256>;
+template<typename T>
+using fixed_4096_config = fixed_allocator<T, 4096>;
+template<typename T>
+using linear_1024_config = fixed_allocator<T, 1024, linear_growth>;
+template<typename T>
+using geometric_64_config = fixed_allocator<T, 64, geometric_growth<>>;
+template<typename T>
+using runtime_config = fixed_allocator<T, runtime_capacity, linear_growth>;
+
+
+/**
+ * @brief Read the trace and prepare it for the replay.
+ * @param path [in] - the trace file.
+ * @param prog [out] - the program of the replay.
+ * @return true on success, false if the file is not the trace.
+ */
+bool load_trace(const std::string &path, replay_program &prog)
+{
+  std::FILE *file = std::fopen(path.c_str(), "rb");
+  if (file == nullptr)
+    return false;
+
+  trace_header header;
+  trace_header expected;
+  if (std::fread(&header, sizeof(header), 1, file) != 1 ||
+      !std::equal(header.magic, header.magic + sizeof(header.magic),
+                  expected.magic) ||
+      header.version != TRACE_VERSION ||
+      header.event_size != sizeof(trace_event)) {
+    std::fclose(file);
+    return false;
+  }
+
+  std::map<std::pair<std::uint32_t, std::size_t>, std::uint32_t> targets;
+  std::map<std::pair<std::uint32_t, std::uint64_t>,
+           std::pair<std::uint32_t, std::uint32_t>> live;  /* target, slot */
+
+  trace_event event;
+  while (std::fread(&event, sizeof(event), 1, file) == 1) {
+    if (event.op == trace_free) {
+      auto it = live.find(std::make_pair(event.allocator, event.addr));
+      if (it == live.end()) {
+        ++prog.skipped;
+        continue;
+      }
+      prog.ops.push_back({it->second.first, it->second.second, event.count,
+                          false});
+      live.erase(it);
+      continue;
+    }
+
+    std::size_t cell = 0;
+    for (std::size_t size: REPLAY_SIZES)
+      if (cell == 0 && event.size <= size)
+        cell = size;
+    if (cell == 0) {
+      ++prog.skipped;
+      continue;
+    }
+
+    auto key = std::make_pair(event.allocator, cell);
+    auto it = targets.find(key);
+    if (it == targets.end()) {
+      it = targets.emplace(key, static_cast<std::uint32_t>(
+                                  prog.cells.size())).first;
+      prog.cells.push_back(cell);
+    }
+
+    std::uint32_t slot = static_cast<std::uint32_t>(prog.slots++);
+    prog.ops.push_back({it->second, slot, event.count, true});
+    live[std::make_pair(event.allocator, event.addr)] =
+        std::make_pair(it->second, slot);
+  }
+
+  std::fclose(file);
+  return true;
+}
+
+
+/**
+ * @brief Run the program once.
+ * @tparam A - the configuration.
+ * @param prog [in] - the program of the replay.
+ * @param account [in] - follow the memory in use, the replay is not timed.
+ * @return the result of the replay.
+ */
+template<template<typename> class A>
+replay_result run_replay(const replay_program &prog, bool account)
+{
+  replay_result res;
+  std::vector<std::unique_ptr<replay_target>> targets;
+  for (std::size_t cell: prog.cells)
+    targets.push_back(make_target<A>(cell));
+
+  std::vector<void *> slots(prog.slots, nullptr);
+  std::vector<const replay_op *> owners(prog.slots, nullptr);
+  std::vector<std::size_t> reserved(targets.size(), 0);
+  std::size_t reserved_bytes = 0;
+  std::size_t run_bytes = 0;    /* requests of several objects */
+
+  auto start = std::chrono::steady_clock::now();
+  for (const replay_op &op: prog.ops) {
+    replay_target &target = *targets[op.target];
+    std::size_t bytes = op.count * prog.cells[op.target];
+
+    if (op.alloc) {
+      try {
+        slots[op.slot] = target.alloc(op.count);
+        owners[op.slot] = &op;
+      }
+      catch (const std::bad_alloc &) {
+        ++res.failures;
+        continue;
+      }
+
+      if (account) {
+        std::size_t now = target.reserved();
+        reserved_bytes += now - reserved[op.target];
+        reserved[op.target] = now;
+        if (now == 0 || op.count > 1)
+          run_bytes += bytes;
+        if (reserved_bytes + run_bytes > res.peak_bytes)
+          res.peak_bytes = reserved_bytes + run_bytes;
+      }
+    }
+    else if (slots[op.slot] != nullptr) {
+      target.free(slots[op.slot], op.count);
+      slots[op.slot] = nullptr;
+      if (account && (reserved[op.target] == 0 || op.count > 1))
+        run_bytes -= bytes;
+    }
+  }
+  res.seconds = std::chrono::duration<double>(
+                  std::chrono::steady_clock::now() - start).count();
+
+  /* the memory is not released in the trace */
+  for (std::size_t i = 0; i < slots.size(); ++i)
+    if (slots[i] != nullptr)
+      targets[owners[i]->target]->free(slots[i], owners[i]->count);
+
+  for (const auto &target: targets)
+    res.fallbacks += target->fallbacks();
+  return res;
+}
+
+
+/**
+ * @brief Replay the program with the configuration and print the result.
+ * @tparam A - the configuration.
+ * @param name [in] - name of the configuration.
+ * @param prog [in] - the program of the replay.
+ */
+template<template<typename> class A>
+void replay(const std::string &name, const replay_program &prog)
+{
+  replay_result timed = run_replay<A>(prog, false);
+  replay_result res = run_replay<A>(prog, true);
+
+  double mops = timed.seconds > 0 ? prog.ops.size() / timed.seconds / 1e6 : 0;
+  std::cout << name << ',' << prog.ops.size() << ',' << prog.skipped << ','
+            << res.failures << ',' << res.fallbacks << ',' << res.peak_bytes
+            << ',' << mops << std::endl;
+}
+
+
+/**
+ * @brief Main function / entry point.
+ *
+ * Replays the trace recorded with ALLOCATOR_TRACE with every configuration
+ * and prints the results in CSV: the throughput in millions of operations per
+ * second, the peak of the reserved memory and the memory of the requests for
+ * several objects, the heap fallbacks and the failed allocations.
+ *
+ * The size of the last configuration is taken from the ALLOCATOR_CAPACITY
+ * environment variable, so it is tuned without the rebuild.
+ */
+int main(int argc, char *argv[]) {
+  if (argc < 2) {
+    std::cerr << "Usage: " << argv[0] << " <trace file>" << std::endl;
+    return 1;
+  }
+
+  replay_program prog;
+  if (!load_trace(argv[1], prog)) {
+    std::cerr << "Can not read the trace " << argv[1] << std::endl;
+    return 1;
+  }
+
+  std::cout << "allocator,events,skipped,failures,fallbacks,peak_bytes,"
+               "mops_per_s" << std::endl;
+
+  replay<std_config>("std::allocator", prog);
+  replay<fixed_256_config>("fixed_allocator<256>", prog);
+  replay<fixed_4096_config>("fixed_allocator<4096>", prog);
+  replay<linear_1024_config>("fixed_allocator<1024,linear_growth>", prog);
+  replay<geometric_64_config>("fixed_allocator<64,geometric_growth>", prog);
+  replay<runtime_config>("fixed_allocator<" +
+                         std::to_string(default_runtime_capacity()) +
+                         ",linear_growth>", prog);
+
+  return 0;
+}
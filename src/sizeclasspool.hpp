@@ -0,0 +1,120 @@
+/**
+ ******************************************************************************
+ * @file    sizeclasspool.hpp
+ * @author  Maxim <aveter@bk.ru>
+ * @date    14/05/2019
+ * @brief   Description of the template "Size Class Pool".
+ ******************************************************************************
+ */
+
+#ifndef SIZECLASSPOOL_HPP_
+#define SIZECLASSPOOL_HPP_
+
+#include "chunklist.hpp"
+
+#include <cstddef>
+
+
+/**
+ * Discription of the cell for the run of the several objects.
+ *
+ * @tparam T - the type of the data in the run.
+ * @tparam RUN - number of objects in the run.
+ */
+template<typename T, std::size_t RUN>
+struct cell_run
+{
+  alignas(T) unsigned char data[RUN * sizeof(T)]; /**< - storage of the run */
+};
+
+
+/**
+ * Discription of the segregated pools for the runs of the objects.
+ *
+ * Each size class is a separate "Chunk List" with the cells for RUN, 2 * RUN,
+ * 4 * RUN ... MAX_RUN objects. The request is served by the smallest class
+ * that fits it.
+ * @tparam T - the type of the data in the cells.
+ * @tparam ELEMENTS - the number of objects reserved for each class, by
+ *                   default, see the constructor.
+ * @tparam GROWTH - growth policy of the classes.
+ * @tparam RUN - number of objects in the cell of the first class.
+ * @tparam MAX_RUN - number of objects in the cell of the last class.
+ */
+template<typename T, std::size_t ELEMENTS, typename GROWTH,
+         std::size_t RUN, std::size_t MAX_RUN, bool = (RUN <= MAX_RUN)>
+class size_class_pool
+{
+  public:
+    /**
+     * @brief Constructor.
+     * @param elements [in] - the number of objects reserved for each class.
+     *                        Default on ELEMENTS.
+     */
+    explicit size_class_pool(std::size_t elements = ELEMENTS)
+      : pool_(elements / RUN > 0 ? elements / RUN : 1), next_(elements)
+    {}
+
+    /**
+     * @brief Allocate memory for the run of the objects.
+     * @param n [in] - number of objects.
+     * @return pointer to the memory or nullptr if the class is filled or the
+     *         request is greater than MAX_RUN.
+     */
+    T * alloc(std::size_t n) {
+      if (n <= RUN)
+        return reinterpret_cast<T *>(pool_.alloc());
+      return next_.alloc(n);
+    }
+
+    /**
+     * @brief Deallocate memory of the run of the objects.
+     * @param ptr [in] - pointer to the run.
+     * @param n [in] - number of objects.
+     * @return true if the memory belongs to the pool, otherwise false.
+     */
+    bool dealloc(T *ptr, std::size_t n) {
+      if (n <= RUN)
+        return pool_.dealloc(reinterpret_cast<cell_t *>(ptr));
+      return next_.dealloc(ptr, n);
+    }
+
+
+  private:
+    using cell_t = cell_run<T, RUN>;
+
+    chunk_list<cell_t, runtime_capacity, GROWTH> pool_; /**< - cells of the
+                                                             class */
+    size_class_pool<T, ELEMENTS, GROWTH, RUN * 2, MAX_RUN> next_; /**< - next
+                                                                     classes */
+};
+
+
+/**
+ * The end of the size classes.
+ */
+template<typename T, std::size_t ELEMENTS, typename GROWTH,
+         std::size_t RUN, std::size_t MAX_RUN>
+class size_class_pool<T, ELEMENTS, GROWTH, RUN, MAX_RUN, false>
+{
+  public:
+    explicit size_class_pool(std::size_t = ELEMENTS) {}
+
+    /**
+     * @brief The request is too large for the pool.
+     * @return nullptr.
+     */
+    T * alloc(std::size_t) {
+      return nullptr;
+    }
+
+    /**
+     * @brief The memory does not belong to the pool.
+     * @return false.
+     */
+    bool dealloc(T *, std::size_t) {
+      return false;
+    }
+};
+
+#endif /* SIZECLASSPOOL_HPP_ */
@@ -0,0 +1,617 @@
+/**
+ ******************************************************************************
+ * @file    test.cpp
+ * @author  Maxim <aveter@bk.ru>
+ * @date    02/07/2019
+ * @brief   Checks of the allocators and the containers, run by ctest.
+ ******************************************************************************
+ */
+
+#include "arenaallocator.hpp"
+#include "fixedallocator.hpp"
+#include "flathashmap.hpp"
+#include "inlineallocator.hpp"
+#include "monotonicarena.hpp"
+#include "mpscqueue.hpp"
+#include "nodelist.hpp"
+#include "parallel.hpp"
+#include "persistentlist.hpp"
+#include "poolresource.hpp"
+#include "unrolledlist.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <list>
+#include <map>
+#include <memory>
+#include <memory_resource>
+#include <new>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <thread>
+#include <utility>
+#include <vector>
+
+
+std::size_t failures = 0;   /**< - number of the failed checks. */
+
+
+/**
+ * @brief Check the result, the failure is printed and counted.
+ * @param ok [in] - the result is correct.
+ * @param what [in] - name of the checked result.
+ */
+void check(bool ok, const std::string &what)
+{
+  if (ok)
+    return;
+
+  std::cerr << "check failed: " << what << std::endl;
+  ++failures;
+}
+
+
+/**
+ * @brief The containers of the different types sharing one arena, the
+ *        requests over the size classes and the filled arena.
+ */
+void test_arena()
+{
+  const std::size_t elements = 1000;
+  /* the node of the map is in the class of 4 units */
+  using arena_t = fixed_arena<elements * 4>;
+  using map_t = std::map<int, long, std::less<int>,
+                         arena_allocator<std::pair<const int, long>, arena_t>>;
+  using list_t = node_list<long, arena_allocator<long, arena_t>>;
+
+  auto arena = std::make_shared<arena_t>();
+  map_t map{std::less<int>(), typename map_t::allocator_type(arena)};
+  list_t list{arena_allocator<long, arena_t>(arena)};
+  for (std::size_t i = 0; i < elements; ++i) {
+    map.emplace(static_cast<int>(i), static_cast<long>(i));
+    list.push_front(static_cast<long>(i));
+  }
+
+  map_t moved(std::move(map));
+  long map_sum = 0, list_sum = 0;
+  for (const auto &item: moved)
+    map_sum += item.second;
+  for (long val: list)
+    list_sum += val;
+
+  const long expected = static_cast<long>(elements * (elements - 1) / 2);
+  check(moved.size() == elements && map_sum == expected &&
+        list_sum == expected, "arena_allocator keeps the items");
+  check(moved.get_allocator().arena() == arena &&
+        arena->pooled_count() + arena->fallback_count() == 2 * elements,
+        "the containers share the arena");
+  check(arena_allocator<long, arena_t>(arena) ==
+          arena_allocator<int, arena_t>(arena) &&
+        arena_allocator<long, arena_t>(arena) !=
+          arena_allocator<long, arena_t>(),
+        "arena_allocator is equal with the same arena");
+
+  fixed_arena<2> small;
+  void *large = small.alloc(fixed_arena<2>::MAX_POOLED_BYTES + 1);
+  check(small.fallback_count() == 1 && small.pooled_count() == 0,
+        "the request over the size classes goes to the heap");
+  small.dealloc(large, fixed_arena<2>::MAX_POOLED_BYTES + 1);
+
+  void *cells[3];
+  for (void *&cell: cells)
+    cell = small.alloc(1);
+  check(small.pooled_count() == 2 && small.fallback_count() == 2,
+        "the filled size class goes to the heap");
+  for (void *cell: cells)
+    small.dealloc(cell, 1);
+
+  void *again = small.alloc(1);
+  check(small.pooled_count() == 3 && small.fallback_count() == 2,
+        "the released cell is reused");
+  small.dealloc(again, 1);
+}
+
+
+/**
+ * @brief The list in the monotonic arena, the reuse of the blocks after
+ *        reset() and release(), the alignment and the arena that can not
+ *        grow.
+ */
+void test_monotonic()
+{
+  using arena_t = monotonic_arena<256>;
+  const std::size_t elements = 1000;
+  arena_t arena;
+
+  void *first = arena.alloc(1, 1);
+  {
+    node_list<long, monotonic_allocator<long, arena_t>> list{
+        monotonic_allocator<long, arena_t>(arena)};
+    for (std::size_t i = 0; i < elements; ++i)
+      list.push_back(static_cast<long>(i));
+    long sum = 0;
+    for (long val: list)
+      sum += val;
+    check(sum == static_cast<long>(elements * (elements - 1) / 2),
+          "monotonic_allocator keeps the items");
+  }
+
+  arena.reset();
+  check(arena.alloc(1, 1) == first, "reset() reuses the first block");
+  void *aligned = arena.alloc(8, 64);
+  check(reinterpret_cast<std::uintptr_t>(aligned) % 64 == 0,
+        "monotonic_arena aligns the memory");
+  void *large = arena.alloc(1024, 8);
+  check(large != nullptr, "the large request gets its own block");
+
+  arena.release();
+  check(arena.alloc(1, 1) == first, "release() keeps the first block");
+
+  monotonic_arena<64, no_growth> fixed;
+  fixed.alloc(64, 1);
+  bool thrown = false;
+  try {
+    fixed.alloc(1, 1);
+  }
+  catch (const std::bad_alloc &) {
+    thrown = true;
+  }
+  check(thrown, "the arena without the growth throws std::bad_alloc");
+}
+
+
+/**
+ * @brief Addresses of the values of the list.
+ * @tparam L - the type of the list.
+ * @param list [in] - the list.
+ * @return the addresses in the list order.
+ */
+template<typename L>
+std::vector<const long *> addresses(const L &list)
+{
+  std::vector<const long *> res;
+  for (const long &val: list)
+    res.push_back(&val);
+  return res;
+}
+
+
+/**
+ * @brief The splice and the merge relink the nodes when the memory of the
+ *        other list can be released by this one, otherwise move the values.
+ */
+void test_splice()
+{
+  using fixed_t = node_list<long, fixed_allocator<long, 16, linear_growth>>;
+  fixed_t src;
+  for (long i = 0; i < 40; ++i)
+    src.push_back(i);
+  std::vector<const long *> before = addresses(src);
+
+  fixed_t dst;
+  dst.splice_back(src);
+  check(src.empty() && dst.size() == 40 && addresses(dst) == before,
+        "the empty list takes the nodes of fixed_allocator");
+  src.push_back(1);
+  dst.push_back(40);
+  check(src.size() == 1 && dst.size() == 41 && dst.back() == 40,
+        "the lists keep their pools after the splice");
+
+  fixed_t other;
+  other.push_back(100);
+  other.push_back(101);
+  dst.splice_front(other);
+  check(other.empty() && dst.size() == 43 && dst.front() == 100,
+        "the values of the other pool are moved");
+
+  using arena_t = fixed_arena<256>;
+  using arena_list_t = node_list<long, arena_allocator<long, arena_t>>;
+  auto arena = std::make_shared<arena_t>();
+  arena_list_t evens{arena_allocator<long, arena_t>(arena)};
+  arena_list_t odds{arena_allocator<long, arena_t>(arena)};
+  for (long i = 0; i < 20; i += 2) {
+    evens.push_back(i);
+    odds.push_back(i + 1);
+  }
+
+  std::vector<const long *> nodes = addresses(evens);
+  std::vector<const long *> odd_nodes = addresses(odds);
+  nodes.insert(nodes.end(), odd_nodes.begin(), odd_nodes.end());
+  std::size_t pooled = arena->pooled_count();
+  evens.merge(odds);
+
+  std::vector<const long *> merged = addresses(evens);
+  bool sorted = true;
+  long expected = 0;
+  for (long val: evens)
+    sorted = sorted && val == expected++;
+  check(odds.empty() && evens.size() == 20 && sorted,
+        "the merge keeps the order");
+  std::sort(nodes.begin(), nodes.end());
+  std::sort(merged.begin(), merged.end());
+  check(merged == nodes && arena->pooled_count() == pooled,
+        "the merge with the shared arena relinks the nodes");
+}
+
+
+/**
+ * The value which constructor throws on the negative number.
+ */
+struct fragile
+{
+  int val;    /**< - the value */
+
+  /**
+   * @brief Constructor with param.
+   * @param v [in] - the value, std::runtime_error is thrown if it is negative.
+   */
+  fragile(int v)
+    : val(v) {
+    if (v < 0)
+      throw std::runtime_error("fragile");
+  }
+};
+
+
+/**
+ * @brief The list is unchanged if the constructor of the value throws in the
+ *        new node.
+ */
+void test_unrolled()
+{
+  using list_t = unrolled_list<fragile, 4>;
+  auto fails = [](auto add) {
+    try {
+      add();
+    }
+    catch (const std::runtime_error &) {
+      return true;
+    }
+    return false;
+  };
+
+  list_t list;
+  check(fails([&list] { list.emplace_back(-1); }) &&
+        fails([&list] { list.emplace_front(-1); }) &&
+        list.size() == 0 && list.begin() == list.end(),
+        "the empty unrolled_list is unchanged by the failed emplace");
+
+  for (int i = 0; i < 4; ++i)
+    list.emplace_back(i);
+  check(fails([&list] { list.emplace_back(-1); }) &&
+        fails([&list] { list.emplace_front(-1); }),
+        "the emplace into the new node throws");
+
+  int expected = 0;
+  for (const fragile &item: list)
+    if (item.val == expected)
+      ++expected;
+  check(list.size() == 4 && expected == 4,
+        "the full unrolled_list is unchanged by the failed emplace");
+  while (!list.empty())
+    list.pop_front();
+}
+
+
+/**
+ * @brief The parallel algorithms against the serial loop, the segment of
+ *        every worker and the call from the worker of the same pool.
+ */
+void test_parallel()
+{
+  const std::size_t elements = 10000;
+  node_list<long, fixed_allocator<long, elements>> list;
+  for (std::size_t i = 0; i < elements; ++i)
+    list.push_back(static_cast<long>(i));
+
+  thread_pool pool(3);
+  auto segments = make_segments(pool, list);
+  check(segments.count() == pool.size() + 1,
+        "the calling thread takes a segment besides the workers");
+
+  auto square = [](long val) { return val * val; };
+  long serial = 0;
+  std::size_t even = 0;
+  for (long val: list) {
+    serial += square(val);
+    even += val % 2 == 0;
+  }
+  check(parallel_transform_reduce(pool, segments, 0L, std::plus<long>(),
+                                  square) == serial,
+        "parallel_transform_reduce is the serial sum");
+  check(parallel_count_if(pool, list, [](long val) { return val % 2 == 0; })
+          == even, "parallel_count_if is the serial count");
+
+  parallel_for_each(pool, segments, [](long &val) { val = -val; });
+  long negated = 0;
+  for (long val: list)
+    negated += val;
+  check(negated == -static_cast<long>(elements * (elements - 1) / 2),
+        "parallel_for_each visits every item once");
+
+  thread_pool single(1);
+  auto nested = single.submit([&single, &list] {
+    return parallel_count_if(single, list, [](long val) { return val < 0; });
+  });
+  check(nested.get() == elements - 1,
+        "the call from the worker runs inline");
+}
+
+
+/**
+ * @brief The snapshot is saved, mapped and changed in place without changing
+ *        the file, the damaged file is rejected.
+ */
+void test_snapshot()
+{
+  const std::string path = "test_snapshot.bin";
+  node_list<int> list;
+  for (int i = 0; i < 100; ++i)
+    list.push_back(i);
+  save_snapshot(list, path);
+
+  {
+    mapped_list<int> mapped(path);
+    int expected = 0;
+    for (int &val: mapped)
+      if (val == expected++)
+        val = -val;
+    check(mapped.size() == 100 && expected == 100 && mapped.back() == -99,
+          "the mapped list is walked and changed in place");
+    check(mapped.to_list().front() == 0 && mapped.to_list().size() == 100,
+          "to_list() copies the changed values");
+  }
+
+  mapped_list<int> reopened(path, true);
+  int sum = 0;
+  for (int val: reopened)
+    sum += val;
+  check(sum == 99 * 100 / 2, "the changes are not written to the file");
+
+  auto rejects = [&path](bool check_links) {
+    try {
+      mapped_list<int> damaged(path, check_links);
+    }
+    catch (const std::runtime_error &) {
+      return true;
+    }
+    return false;
+  };
+
+  {
+    std::fstream file(path, std::ios::binary | std::ios::in | std::ios::out);
+    std::uint64_t loop = snapshot_nodes_offset<int>();
+    file.seekp(static_cast<std::streamoff>(loop));
+    file.write(reinterpret_cast<const char *>(&loop), sizeof(loop));
+  }
+  check(!rejects(false) && rejects(true),
+        "the loop of the links is found by the full check");
+
+  {
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    file << "not a snapshot";
+  }
+  check(rejects(false), "the file which is not the snapshot is rejected");
+  std::remove(path.c_str());
+
+  bool missing = false;
+  try {
+    mapped_list<int> none(path);
+  }
+  catch (const std::system_error &) {
+    missing = true;
+  }
+  check(missing, "the missing file throws std::system_error");
+}
+
+
+/**
+ * @brief The standard container keeps its small data in the allocator, the
+ *        copy and the rebound allocator have their own storage.
+ */
+void test_inline()
+{
+  using alloc_t = inline_allocator<std::pair<const int, int>, 16>;
+  using map_t = std::map<int, int, std::less<int>, alloc_t>;
+
+  map_t map;
+  for (int i = 0; i < 32; ++i)
+    map.emplace(i, i * i);
+  long sum = 0;
+  for (const auto &item: map)
+    sum += item.second;
+  check(map.size() == 32 && sum == 31 * 32 * 63 / 6,
+        "std::map keeps the items in inline_allocator");
+  check(map.get_allocator().fallback_count() == 0,
+        "get_allocator() returns the rebound allocator");
+
+  inline_allocator<int, 4> alloc;
+  inline_allocator<long, 4> rebound(alloc);
+  inline_allocator<int, 4> copied(alloc);
+  check(alloc == alloc && alloc != rebound && alloc != copied,
+        "inline_allocator is equal only to itself");
+
+  int *cells[5];
+  for (int *&cell: cells)
+    cell = alloc.allocate(1);
+  check(alloc.fallback_count() == 1, "the overflow goes to the heap");
+  for (int *cell: cells)
+    alloc.deallocate(cell, 1);
+  check(alloc.allocate(1) == cells[3], "the inline cell is reused");
+}
+
+
+/**
+ * @brief The std::pmr list on the arena, the requests which the arena can not
+ *        serve go to the heap and to the upstream resource.
+ */
+void test_pool_resource()
+{
+  const std::size_t elements = 1000;
+  pool_resource<fixed_arena<elements>> pool;
+  {
+    std::pmr::list<long> list(&pool);
+    for (std::size_t i = 0; i < elements; ++i)
+      list.push_back(static_cast<long>(i));
+    list.remove_if([](long val) { return val % 2 != 0; });
+
+    long sum = 0;
+    for (long val: list)
+      sum += val;
+    const long half = static_cast<long>(elements / 2);
+    check(list.size() == elements / 2 && sum == half * (half - 1),
+          "std::pmr::list keeps the items");
+  }
+  check(pool.arena().pooled_count() == elements &&
+        pool.arena().fallback_count() == 0,
+        "pool_resource serves the list from the arena");
+  check(pool.is_equal(pool) && !pool.is_equal(*std::pmr::new_delete_resource()),
+        "pool_resource is equal only to itself");
+
+  pool_resource<fixed_arena<1>> small(std::pmr::null_memory_resource());
+  void *first = small.allocate(8);
+  void *second = small.allocate(8);
+  check(small.arena().pooled_count() == 1 &&
+        small.arena().fallback_count() == 1,
+        "the filled arena goes to the heap");
+  small.deallocate(second, 8);
+  small.deallocate(first, 8);
+
+  bool thrown = false;
+  try {
+    static_cast<void>(small.allocate(8, 2 * alignof(std::max_align_t)));
+  }
+  catch (const std::bad_alloc &) {
+    thrown = true;
+  }
+  check(thrown && small.upstream_resource() == std::pmr::null_memory_resource(),
+        "the over-aligned request goes to the upstream resource");
+}
+
+
+/**
+ * @brief Every message of several producers is received once and in the
+ *        order of its producer, the failed push leaves the queue usable.
+ */
+void test_mpsc()
+{
+  const std::size_t threads = 4;
+  const std::size_t elements = 10000;
+  mpsc_queue<long> queue;
+  std::vector<long> last(threads, -1);
+  bool ordered = true;
+
+  std::vector<std::thread> producers;
+  for (std::size_t t = 0; t < threads; ++t)
+    producers.emplace_back([&queue, t] {
+      for (std::size_t i = 0; i < elements; ++i)
+        queue.push(static_cast<long>(t * elements + i));
+    });
+
+  long msg;
+  for (std::size_t received = 0; received < threads * elements; ) {
+    if (!queue.try_pop(msg))
+      continue;
+
+    std::size_t t = static_cast<std::size_t>(msg) / elements;
+    ordered = ordered && t < threads && msg > last[t];
+    last[t] = msg;
+    ++received;
+  }
+  for (std::thread &thr: producers)
+    thr.join();
+
+  bool all = queue.empty();
+  for (std::size_t t = 0; t < threads; ++t)
+    all = all && last[t] == static_cast<long>((t + 1) * elements - 1);
+  check(ordered && all, "mpsc_queue delivers every message in order");
+
+  mpsc_queue<fragile> values;
+  bool thrown = false;
+  try {
+    values.emplace(-1);
+  }
+  catch (const std::runtime_error &) {
+    thrown = true;
+  }
+  values.emplace(1);
+  fragile value(0);
+  check(thrown && values.try_pop(value) && value.val == 1 && values.empty(),
+        "the failed constructor of the message leaves the queue unchanged");
+
+  mpsc_queue<long, concurrent_allocator<long, 64>> small;
+  long pushed = 0;
+  try {
+    for (;;)
+      small.push(pushed++);
+  }
+  catch (const std::bad_alloc &) {
+    --pushed;
+  }
+
+  long expected = 0;
+  while (small.try_pop(msg) && msg == expected)
+    ++expected;
+  small.push(expected);
+  check(pushed > 0 && pushed < 64 && expected == pushed &&
+        small.try_pop(msg) && msg == pushed && small.empty(),
+        "the exhausted pool throws std::bad_alloc and the queue goes on");
+}
+
+
+/**
+ * @brief The flat hash map against the inserted keys, the copy of the empty
+ *        map takes no table.
+ */
+void test_flat_hash_map()
+{
+  using map_t = flat_hash_map<int, long>;
+  map_t empty;
+  map_t empty_copy(empty);
+  check(empty_copy.capacity() == 0 && empty_copy.find(1) == empty_copy.end(),
+        "the copy of the empty map takes no table");
+  empty_copy = empty;
+  check(empty_copy.capacity() == 0, "the empty map is assigned without table");
+
+  map_t map;
+  for (int i = 0; i < 1000; ++i)
+    map.try_emplace(i, static_cast<long>(i) * 2);
+  for (int i = 0; i < 1000; i += 2)
+    map.erase(i);
+
+  map_t copy(map);
+  bool found = copy.size() == 500;
+  for (int i = 0; i < 1000; ++i) {
+    auto it = copy.find(i);
+    found = found && (i % 2 == 0 ? it == copy.end()
+                                 : it != copy.end() && it->second == 2L * i);
+  }
+  check(found, "flat_hash_map keeps the items after the erase and the copy");
+}
+
+
+int main() {
+  test_arena();
+  test_monotonic();
+  test_splice();
+  test_unrolled();
+  test_parallel();
+  test_snapshot();
+  test_inline();
+  test_pool_resource();
+  test_mpsc();
+  test_flat_hash_map();
+
+  if (failures != 0) {
+    std::cerr << failures << " checks failed" << std::endl;
+    return EXIT_FAILURE;
+  }
+  return 0;
+}
@@ -0,0 +1,515 @@
+/**
+ ******************************************************************************
+ * @file    unrolledlist.hpp
+ * @author  Maxim <aveter@bk.ru>
+ * @date    30/05/2019
+ * @brief   Description of the template "Unrolled List".
+ ******************************************************************************
+ */
+
+#ifndef UNROLLEDLIST_HPP_
+#define UNROLLEDLIST_HPP_
+
+#include <cstddef>
+#include <iterator>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+
+/* Forward ad */
+template<typename T, std::size_t N, typename A>
+class unrolled_list;
+
+
+/**
+ * Discription of the node of the unrolled list.
+ *
+ * The node keeps up to N values in the contiguous array, the values occupy
+ * the cells [first, first + count).
+ * @tparam T - the type of variable stored in the node.
+ * @tparam N - number of the cells in the node.
+ */
+template<typename T, std::size_t N>
+struct unrolled_node
+{
+  unrolled_node *next;    /**< - next node. */
+  std::size_t first;      /**< - index of the first occupied cell. */
+  std::size_t count;      /**< - number of the occupied cells. */
+
+  alignas(T) unsigned char items[N * sizeof(T)];  /**< - cells of the values */
+
+  /**
+   * @brief Constructor.
+   * @param start [in] - index of the first cell to be occupied.
+   */
+  explicit unrolled_node(std::size_t start)
+    : next(nullptr), first(start), count(0)
+  {}
+
+  /**
+   * @brief Access to the cell.
+   * @param idx [in] - index of the cell.
+   * @return pointer to the value.
+   */
+  T * at(std::size_t idx) {
+    return reinterpret_cast<T *>(items) + idx;
+  }
+};
+
+
+/**
+ * Discription of an iterator for working with the unrolled list.
+ *
+ * @tparam T - the type of variable stored in the list.
+ * @tparam N - number of the cells in the node.
+ * @tparam V - the type of the access to the value: const T for the constant
+ *             iterator, T for the mutable one.
+ */
+template<typename T, std::size_t N, typename V>
+class unrolled_iterator
+{
+  public:
+    /* Aliases */
+    using iterator_category = std::forward_iterator_tag;
+    using value_type = T;
+    using difference_type = std::ptrdiff_t;
+    using pointer = V *;
+    using reference = V &;
+
+    /**
+     * @brief Constructor with param.
+     * @param p [in] - pointer to the node. Default p = nullptr.
+     * @param idx [in] - index of the cell in the node.
+     */
+    unrolled_iterator(unrolled_node<T, N> *p = nullptr, std::size_t idx = 0)
+      : ptr_(p), idx_(idx)
+    {}
+
+    /**
+     * @brief Conversion of the mutable iterator to the constant one.
+     * @param other [in] - mutable iterator.
+     */
+    template<typename U, typename = typename std::enable_if<
+                           std::is_same<U, T>::value &&
+                           std::is_const<V>::value>::type>
+    unrolled_iterator(const unrolled_iterator<U, N, U> &other)
+      : ptr_(other.ptr_), idx_(other.idx_)
+    {}
+
+    /**
+     * @brief Inequality operator.
+     * @param  other [in] - iterator.
+     * @return true if the iterators are not equal and false otherwise.
+     */
+    bool operator!=(unrolled_iterator const &other) const {
+      return ptr_ != other.ptr_ || idx_ != other.idx_;
+    }
+
+    /**
+     * @brief Comparison operator.
+     * @param other [in] - iterator
+     * @return true if equal and false otherwise.
+     */
+    bool operator==(unrolled_iterator const &other) const {
+      return !(*this != other);
+    }
+
+    /**
+     * @brief Dereference operator.
+     * @return reference on the data.
+     */
+    V & operator*() const {
+      return *ptr_->at(idx_);
+    }
+
+    /**
+     * @brief Pointer selector operator.
+     * @return pointer on the data.
+     */
+    V * operator->() const {
+      return ptr_->at(idx_);
+    }
+
+    /**
+     * @brief Increment operator.
+     * @return increment data.
+     */
+    unrolled_iterator & operator++() {
+      if (ptr_ && ++idx_ == ptr_->first + ptr_->count) {
+        ptr_ = ptr_->next;
+        idx_ = ptr_ ? ptr_->first : 0;
+      }
+      return *this;
+    }
+
+    /**
+     * @brief Postfix increment operator.
+     * @return the iterator before the increment.
+     */
+    unrolled_iterator operator++(int) {
+      unrolled_iterator tmp(*this);
+      ++(*this);
+      return tmp;
+    }
+
+
+  private:
+    unrolled_node<T, N> *ptr_{nullptr};   /**< - pointer to the node. */
+    std::size_t idx_ = 0;                 /**< - index of the cell. */
+
+    /* Friends */
+    template<typename, std::size_t, typename>
+    friend class unrolled_iterator;
+};
+
+
+/**
+ * Swap the unrolled list.
+ *
+ * @tparam Tp - the type of variable stored in the list.
+ * @tparam Sz - number of the cells in the node.
+ * @tparam Aloc - allocator, memory manager for working with container.
+ * @param dst [in] - receiving container.
+ * @param src [out] - source container.
+ */
+template<typename Tp, std::size_t Sz, typename Aloc>
+void swap(unrolled_list<Tp, Sz, Aloc> &dst, unrolled_list<Tp, Sz, Aloc> &src)
+{
+  std::swap(dst.head_, src.head_);
+  std::swap(dst.tail_, src.tail_);
+  std::swap(dst.allocator, src.allocator);
+  std::swap(dst.size_, src.size_);
+}
+
+
+/**
+ * Discription of the container "Unrolled List".
+ *
+ * This is the singly linked list where every node keeps the small array of
+ * the values, so the iteration reads the contiguous memory and the overhead
+ * of the links is divided by N. The nodes are allocated one by one with the
+ * allocator rebound to the node type, so it works with "Fixed Allocator".
+ * @tparam T - the type of variable stored in the list.
+ * @tparam N - number of the values in the node. Default on 16.
+ * @tparam A - allocator, memory manager for working with container. Default on
+ *             std::allocator.
+ */
+template<typename T, std::size_t N = 16, typename A = std::allocator<T>>
+class unrolled_list
+{
+  static_assert(N > 0, "The node must keep at least one value");
+
+  public:
+    /* Aliases */
+    using node_t = unrolled_node<T, N>;
+    using allocator_t =
+            typename std::allocator_traits<A>::template rebind_alloc<node_t>;
+    using iterator_t = unrolled_iterator<T, N, T>;
+    using const_iterator_t = unrolled_iterator<T, N, const T>;
+
+    /**
+     * The default constructor.
+     */
+    unrolled_list() = default;
+
+    /**
+     * @brief Constructor with the memory manager.
+     * @param alloc [in] - allocator, is rebound to the node type.
+     */
+    explicit unrolled_list(const A &alloc)
+      : allocator(alloc)
+    {}
+
+    /**
+     * The distructor
+     */
+    virtual ~unrolled_list() {
+      clear();
+    }
+
+    /**
+     * @brief Copy constructor.
+     * @param other [in] - the object to copy.
+     */
+    unrolled_list(const unrolled_list &other)
+      : allocator(std::allocator_traits<allocator_t>::
+                    select_on_container_copy_construction(other.allocator)) {
+      for (const T &val: other)
+        push_back(val);
+    }
+
+    /**
+     * @brief Move constructor.
+     * @param other [in] - the object to move.
+     */
+    unrolled_list(unrolled_list &&other)
+      : size_(other.size_), head_(other.head_), tail_(other.tail_),
+        allocator(std::move(other.allocator)) {
+      other.size_ = 0;
+      other.head_ = nullptr;
+      other.tail_ = nullptr;
+    }
+
+    /**
+     * @brief Copy operator.
+     * @param other [in] - the object to copy.
+     */
+    unrolled_list & operator=(const unrolled_list &other) {
+      if (this != &other) {
+        clear();
+        for (const T &val: other)
+          push_back(val);
+      }
+      return *this;
+    }
+
+    /**
+     * @brief Move operator.
+     * @param other [in] - the object to move.
+     */
+    unrolled_list & operator=(unrolled_list &&other) {
+      swap(*this, other);
+      return *this;
+    }
+
+    /**
+     * @brief  The begin iterator of the list.
+     * @return Returns an iterator to the beginning of the list.
+     */
+    iterator_t begin() {
+      return head_ ? iterator_t(head_, head_->first) : iterator_t();
+    }
+
+    /**
+     * @brief  The end iterator of the list.
+     * @return Returns an iterator to the end of the list.
+     */
+    iterator_t end() {
+      return iterator_t();
+    }
+
+    /**
+     * @brief  The begin iterator of the constant list.
+     * @return Returns an const iterator to the beginning of the list.
+     */
+    const_iterator_t begin() const {
+      return cbegin();
+    }
+
+    /**
+     * @brief  The end iterator of the constant list.
+     * @return Returns an const iterator to the end of the list.
+     */
+    const_iterator_t end() const {
+      return cend();
+    }
+
+    /**
+     * @brief  The const begin iterator of the list.
+     * @return Returns an const iterator to the beginning of the list.
+     */
+    const_iterator_t cbegin() const {
+      return head_ ? const_iterator_t(head_, head_->first) : const_iterator_t();
+    }
+
+    /**
+     * @brief  The const end iterator of the list.
+     * @return Returns an const iterator to the end of the list.
+     */
+    const_iterator_t cend() const { return const_iterator_t(); }
+
+    /**
+     * @brief The number of data in the list.
+     * @return The number of data.
+     */
+    std::size_t size() const {
+      return size_;
+    }
+
+    /**
+     * @brief Check that the list has no data.
+     * @return true if the list is empty, otherwise false.
+     */
+    bool empty() const {
+      return size_ == 0;
+    }
+
+    /**
+     * @brief The first item of the list, the list must not be empty.
+     * @return reference to the data.
+     */
+    T & front() {
+      return *head_->at(head_->first);
+    }
+
+    /**
+     * @brief The last item of the list, the list must not be empty.
+     * @return reference to the data.
+     */
+    T & back() {
+      return *tail_->at(tail_->first + tail_->count - 1);
+    }
+
+    /**
+     * @brief Add an item to the top of the list (variable number of params).
+     * @tparam ...Args - params.
+     * @param args [in] - add value.
+     */
+    template<typename... Args>
+    void push_front(Args &&... args) {
+      emplace_front(std::forward<Args>(args)...);
+    }
+
+    /**
+     * @brief Add an item to the back of the list (variable number of params).
+     * @tparam ...Args - params.
+     * @param args [in] - add value.
+     */
+    template<typename... Args>
+    void push_back(Args &&... args) {
+      emplace_back(std::forward<Args>(args)...);
+    }
+
+    /**
+     * @brief Construct an item at the top of the list.
+     * @tparam ...Args - params.
+     * @param args [in] - constructor params of the value.
+     * @return iterator to the new item.
+     */
+    template<typename... Args>
+    iterator_t emplace_front(Args &&... args) {
+      if (head_ != nullptr && head_->first > 0) {
+        std::size_t idx = head_->first - 1;
+        ::new((void *) head_->at(idx)) T(std::forward<Args>(args)...);
+        head_->first = idx;
+        ++head_->count;
+        ++size_;
+        return iterator_t(head_, idx);
+      }
+
+      node_t *new_node = make_item_node(N - 1, std::forward<Args>(args)...);
+      new_node->next = head_;
+      head_ = new_node;
+      if (tail_ == nullptr)
+        tail_ = new_node;
+      ++size_;
+      return iterator_t(head_, N - 1);
+    }
+
+    /**
+     * @brief Construct an item at the back of the list.
+     * @tparam ...Args - params.
+     * @param args [in] - constructor params of the value.
+     * @return iterator to the new item.
+     */
+    template<typename... Args>
+    iterator_t emplace_back(Args &&... args) {
+      if (tail_ != nullptr && tail_->first + tail_->count < N) {
+        std::size_t idx = tail_->first + tail_->count;
+        ::new((void *) tail_->at(idx)) T(std::forward<Args>(args)...);
+        ++tail_->count;
+        ++size_;
+        return iterator_t(tail_, idx);
+      }
+
+      node_t *new_node = make_item_node(0, std::forward<Args>(args)...);
+      if (tail_ == nullptr)
+        head_ = new_node;
+      else
+        tail_->next = new_node;
+      tail_ = new_node;
+      ++size_;
+      return iterator_t(tail_, 0);
+    }
+
+    /**
+     * @brief Remove the first item, the list must not be empty.
+     */
+    void pop_front() {
+      head_->at(head_->first)->~T();
+      ++head_->first;
+      --size_;
+
+      if (--head_->count == 0) {
+        node_t *old = head_;
+        head_ = old->next;
+        if (head_ == nullptr)
+          tail_ = nullptr;
+        drop_node(old);
+      }
+    }
+
+    /**
+     * @brief Remove all the items.
+     */
+    void clear() {
+      while (head_) {
+        node_t *next = head_->next;
+        for (std::size_t i = 0; i < head_->count; ++i)
+          head_->at(head_->first + i)->~T();
+        drop_node(head_);
+        head_ = next;
+      }
+      tail_ = nullptr;
+      size_ = 0;
+    }
+
+
+  private:
+    std::size_t size_ = 0;    /**< - number of data in the list */
+    node_t *head_ = nullptr;  /**< - pointer to the head on the list */
+    node_t *tail_ = nullptr;  /**< - pointer to the tail on the list */
+    allocator_t allocator{};  /**< - memory manager */
+
+    /* Friends function */
+    template<typename Tp, std::size_t Sz, typename Aloc>
+    friend void swap(unrolled_list<Tp, Sz, Aloc> &dst,
+                     unrolled_list<Tp, Sz, Aloc> &src);
+
+    /**
+     * @brief Allocate and construct the empty node.
+     * @param start [in] - index of the first cell to be occupied.
+     * @return pointer to the new node.
+     */
+    node_t * make_node(std::size_t start) {
+      node_t *new_node = allocator.allocate(1);
+      ::new((void *) new_node) node_t(start);
+      return new_node;
+    }
+
+    /**
+     * @brief Allocate the node with one item, it is not linked.
+     *
+     * If the constructor of the value throws, the node is released.
+     * @tparam ...Args - params.
+     * @param idx [in] - index of the cell of the item.
+     * @param args [in] - constructor params of the value.
+     * @return pointer to the new node.
+     */
+    template<typename... Args>
+    node_t * make_item_node(std::size_t idx, Args &&... args) {
+      node_t *new_node = make_node(idx);
+      try {
+        ::new((void *) new_node->at(idx)) T(std::forward<Args>(args)...);
+      }
+      catch (...) {
+        drop_node(new_node);
+        throw;
+      }
+      new_node->count = 1;
+      return new_node;
+    }
+
+    /**
+     * @brief Deallocate the node, its values must be destroyed.
+     * @param ptr_node [in] - pointer to the node.
+     */
+    void drop_node(node_t *ptr_node) {
+      ptr_node->~node_t();
+      allocator.deallocate(ptr_node, 1);
+    }
+};
+
+#endif /* UNROLLEDLIST_HPP_ */